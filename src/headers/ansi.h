@@ -103,7 +103,7 @@
 /* Pure Function Annotations for Functional Programming */
 #define _PURE_FUNCTION      __attribute__((const))
 #define _NO_SIDE_EFFECTS    __attribute__((pure))
-#define _ALWAYS_INLINE      __attribute__((always_inline)) inline
+#define _ALWAYS_INLINE      __attribute__((always_inline)) __inline__
 #define _FLATTEN            __attribute__((flatten))
 #define _HOT                __attribute__((hot))
 #define _COLD               __attribute__((cold))
@@ -116,6 +116,7 @@
 typedef int __attribute__((vector_size(32))) mimix_v8si; /* 8 x 32-bit integers */
 typedef float __attribute__((vector_size(32))) mimix_v8sf; /* 8 x 32-bit floats */
 typedef double __attribute__((vector_size(32))) mimix_v4df; /* 4 x 64-bit doubles */
+typedef char __attribute__((vector_size(32))) mimix_v32qi; /* 32 x 8-bit bytes */
 
 /* Vectorization Directives */
 #define _VECTORIZE_AVX256
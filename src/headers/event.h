@@ -0,0 +1,108 @@
+/* Event Dispatch Header for MIMIX 3.1.2 Microkernel
+ *
+ * Functional Paradigm: Vectored handler table, batched dispatch
+ * Big O Complexity: O(r log r) per pass for r ready vectors (r <= 64)
+ * Memory Optimization: One read(2) per vector per pass, not per event
+ * Architecture: eventfd(2), timerfd(2), signalfd(2) multiplexed by epoll(7)
+ *
+ * Hosted model of the isr_default -> interrupt_handler path. Each vector
+ * is backed by one file descriptor and one handler, registered the same
+ * way system calls are registered in syscall_table. A dispatch pass waits
+ * for readiness, drains every ready vector and calls its handler once
+ * with the number of events that arrived since the previous pass; lower
+ * vectors are dispatched first.
+ *
+ * Adaptive coalescing (interrupt moderation): when a pass finds at least
+ * MIMIX_EVENT_COALESCE_HIGH events, the next pass holds off before
+ * draining so that further events share the same wakeup, doubling the
+ * hold-off up to the loop's limit. A pass with at most
+ * MIMIX_EVENT_COALESCE_LOW events drops back to immediate dispatch.
+ * Hold-offs are shorter than the default 50 us timer slack:
+ * mimix_event_run lowers the slack of its thread while it runs, callers
+ * driving mimix_event_dispatch themselves should set PR_SET_TIMERSLACK.
+ *
+ * Functions return 0 on success and -1 with errno set on failure.
+ */
+
+#ifndef _MIMIX_EVENT_H
+#define _MIMIX_EVENT_H
+
+#include <headers/ansi.h>  /* Must precede system headers, see _POSIX_SOURCE */
+#include <signal.h>
+
+/* Vector Table */
+#define MIMIX_EVENT_VECTORS        64    /* Handler table size */
+#define MIMIX_EVENT_BATCH          MIMIX_EVENT_VECTORS  /* Ready per wait */
+
+/* Coalescing Policy */
+#define MIMIX_EVENT_HOLDOFF_MAX    (50UL * 1000)  /* Default limit, ns */
+#define MIMIX_EVENT_HOLDOFF_MIN    (2UL * 1000)   /* First step, ns */
+#define MIMIX_EVENT_HOLDOFF_LIMIT  999999999UL    /* One nanosleep, ns */
+#define MIMIX_EVENT_COALESCE_HIGH  16    /* Events per pass to grow */
+#define MIMIX_EVENT_COALESCE_LOW   2     /* Events per pass to go idle */
+
+/* Vector Source Kinds */
+#define MIMIX_EVENT_SOURCE_NONE    0
+#define MIMIX_EVENT_SOURCE_EVENTFD 1     /* Software-raised */
+#define MIMIX_EVENT_SOURCE_TIMERFD 2     /* Periodic timer */
+#define MIMIX_EVENT_SOURCE_SIGNALFD 3    /* POSIX signal */
+
+/* Handler: count events arrived on vector since its last dispatch */
+typedef void (*mimix_event_handler_t)(unsigned int vector,
+		unsigned long count, void *arg);
+
+/* Vector Table Entry */
+typedef struct mimix_event_vector {
+	int fd;                           /* Source descriptor, -1 if none */
+	int kind;                         /* MIMIX_EVENT_SOURCE_* */
+	mimix_event_handler_t handler;
+	void *arg;
+} mimix_event_vector_t;
+
+/* Dispatch Counters */
+typedef struct mimix_event_stats {
+	unsigned long passes;             /* Passes that found work */
+	unsigned long dispatches;         /* Handler invocations */
+	unsigned long events;             /* Events delivered */
+	unsigned long holdoffs;           /* Passes that coalesced */
+} mimix_event_stats_t;
+
+/* Dispatch Loop */
+typedef struct mimix_event_loop {
+	int epfd;
+	int stop;                         /* Set by mimix_event_stop */
+	unsigned long holdoff_ns;         /* Current hold-off, 0 = immediate */
+	unsigned long holdoff_max_ns;     /* 0 disables coalescing */
+	sigset_t blocked;                 /* Signals this loop blocked */
+	mimix_event_stats_t stats;
+	mimix_event_vector_t wake;        /* eventfd that interrupts a wait */
+	mimix_event_vector_t vectors[MIMIX_EVENT_VECTORS];
+} mimix_event_loop_t;
+
+/* Loop lifetime; destroy unblocks the signals add_signal blocked.
+ * init fails with EINVAL if holdoff_max_ns exceeds MIMIX_EVENT_HOLDOFF_LIMIT
+ */
+int mimix_event_init(mimix_event_loop_t *loop, unsigned long holdoff_max_ns);
+void mimix_event_destroy(mimix_event_loop_t *loop);
+
+/* Vector table: one handler and one source per vector */
+int mimix_event_register(mimix_event_loop_t *loop, unsigned int vector,
+		mimix_event_handler_t handler, void *arg);
+int mimix_event_add_eventfd(mimix_event_loop_t *loop, unsigned int vector);
+int mimix_event_add_timer(mimix_event_loop_t *loop, unsigned int vector,
+		unsigned long period_ns);
+int mimix_event_add_signal(mimix_event_loop_t *loop, unsigned int vector,
+		int signo);
+
+/* Raise count events on an eventfd vector; safe from any thread */
+int mimix_event_raise(mimix_event_loop_t *loop, unsigned int vector,
+		unsigned long count);
+
+/* One pass: returns events dispatched, 0 on timeout, -1 on error */
+int mimix_event_dispatch(mimix_event_loop_t *loop, int timeout_ms);
+
+/* Dispatch until mimix_event_stop; stop is safe from any thread */
+int mimix_event_run(mimix_event_loop_t *loop);
+void mimix_event_stop(mimix_event_loop_t *loop);
+
+#endif /* _MIMIX_EVENT_H */
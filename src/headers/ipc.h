@@ -0,0 +1,139 @@
+/* Shared-Memory IPC Header for MIMIX 3.1.2 Microkernel
+ *
+ * Functional Paradigm: Messages are descriptors; payloads never move
+ * Big O Complexity: O(1) send/recv, O(b) grant for b arena blocks
+ * Memory Optimization: Cache-line separated ring indices, page-sized blocks
+ * Architecture: memfd_create(2) region, cross-process futex(2) wakeups
+ *
+ * A channel is one memfd mapped by two endpoints (side 0 and side 1),
+ * which may live in different processes and at different addresses; all
+ * shared structures therefore use offsets, never pointers. Each side owns
+ * one single-producer ring of descriptors. A descriptor names a region of
+ * the shared arena by handle (grant index + generation), so a payload
+ * written once by the sender is read in place by the receiver.
+ *
+ * Grant lifecycle:
+ *   mimix_ipc_grant    Owner allocates a region and fills it in place.
+ *   mimix_ipc_send     Descriptor carrying the handle crosses over.
+ *   mimix_ipc_map      Peer checks the handle and the requested rights.
+ *   mimix_ipc_release  Peer is done; region returns to the arena.
+ *   mimix_ipc_revoke   Owner retires the handle. Later maps fail with
+ *                      ESTALE; a region the peer already mapped stays
+ *                      quarantined until the peer releases it.
+ *
+ * Protection model: cooperative. Both endpoints map the whole region
+ * read-write, grant table included, so rights and revocation are checks
+ * a well-behaved peer runs through mimix_ipc_map to catch use-after-free
+ * and wrong-direction bugs, not a boundary against a hostile one. Only
+ * share a channel with a process trusted with all of its memory.
+ *
+ * Each endpoint is used by one thread at a time (rings are single
+ * producer, single consumer). mimix_ipc_attach takes ownership of fd and
+ * closes it on failure. A failed create or attach leaves fd at -1, so
+ * mimix_ipc_detach on it is harmless.
+ * Functions return 0 on success and -1 with errno set on failure.
+ */
+
+#ifndef _MIMIX_IPC_H
+#define _MIMIX_IPC_H
+
+#include <headers/ansi.h>  /* Must precede system headers, see _POSIX_SOURCE */
+#include <stddef.h>
+
+/* Channel Geometry */
+#define MIMIX_IPC_RING_SLOTS     256   /* Descriptors per direction (2^n) */
+#define MIMIX_IPC_MAX_GRANTS     1024  /* Live grants per channel */
+#define MIMIX_IPC_BLOCK_SIZE     4096  /* Arena allocation granule */
+#define MIMIX_IPC_DEFAULT_ARENA  (64UL * 1024 * 1024)
+
+/* Grant Rights (advisory, checked by mimix_ipc_map) */
+#define MIMIX_IPC_RIGHT_READ     1U
+#define MIMIX_IPC_RIGHT_WRITE    2U
+
+/* Handle with no buffer attached (control messages) */
+#define MIMIX_IPC_CAP_NONE       0UL
+
+/* Grant handle: (generation << 32) | (grant index + 1) */
+typedef unsigned long mimix_ipc_cap_t;
+
+/* Message Descriptor - 32 bytes, two per cache line */
+typedef struct mimix_ipc_desc {
+	mimix_ipc_cap_t cap;              /* Buffer handle or CAP_NONE */
+	unsigned long offset;             /* Start within the grant */
+	unsigned long length;             /* Bytes of payload */
+	unsigned long tag;                /* Caller-defined message type */
+} mimix_ipc_desc_t;
+
+/* Descriptor Ring: written by one side, read by the other
+ * head and tail double as futex words for empty/full waits.
+ */
+typedef struct mimix_ipc_ring {
+	unsigned int head;                /* Producer position */
+	unsigned int head_waiters;        /* Consumer sleeping on head */
+	char _pad_head[_MIMIX_CACHE_LINE - 2 * sizeof(unsigned int)];
+	unsigned int tail;                /* Consumer position */
+	unsigned int tail_waiters;        /* Producer sleeping on tail */
+	char _pad_tail[_MIMIX_CACHE_LINE - 2 * sizeof(unsigned int)];
+	mimix_ipc_desc_t slots[MIMIX_IPC_RING_SLOTS];
+} _CACHE_ALIGN mimix_ipc_ring_t;
+
+/* Grant Table Entry (shared) */
+typedef struct mimix_ipc_grant_entry {
+	unsigned int generation;          /* Bumped on release and revoke */
+	unsigned int state;               /* Free, granted or quarantined */
+	unsigned int owner;               /* Side that created the grant */
+	unsigned int rights;              /* MIMIX_IPC_RIGHT_* for the peer */
+	unsigned int mapped;              /* Peer has mapped this generation */
+	unsigned int _reserved;
+	unsigned long offset;             /* Arena offset */
+	unsigned long length;             /* Requested bytes */
+	unsigned long nblocks;            /* Arena blocks reserved */
+} mimix_ipc_grant_entry_t;
+
+/* Shared Region Header; arena bitmap and arena follow at the offsets */
+typedef struct mimix_ipc_shared {
+	unsigned long magic;
+	unsigned long region_size;
+	unsigned long bitmap_offset;
+	unsigned long arena_offset;
+	unsigned long arena_blocks;
+	unsigned int lock;                /* Futex mutex: grants and bitmap */
+	unsigned int grant_hint;          /* Next grant slot to probe */
+	mimix_ipc_ring_t ring[2];         /* ring[s] is produced by side s */
+	mimix_ipc_grant_entry_t grants[MIMIX_IPC_MAX_GRANTS];
+} _CACHE_ALIGN mimix_ipc_shared_t;
+
+/* Process-Local Endpoint */
+typedef struct mimix_ipc_channel {
+	int fd;                           /* memfd, pass to the peer */
+	int side;                         /* 0 or 1 */
+	size_t size;
+	mimix_ipc_shared_t *shm;
+	unsigned char *arena;             /* Local address of the arena */
+} mimix_ipc_channel_t;
+
+/* Channel setup: create makes side 0, the peer attaches the fd as side 1 */
+int mimix_ipc_create(mimix_ipc_channel_t *ch, size_t arena_bytes);
+int mimix_ipc_attach(mimix_ipc_channel_t *ch, int fd, int side);
+void mimix_ipc_detach(mimix_ipc_channel_t *ch);
+
+/* Grants */
+int mimix_ipc_grant(mimix_ipc_channel_t *ch, size_t length,
+		unsigned int rights, mimix_ipc_cap_t *cap, void **buf);
+void *mimix_ipc_map(mimix_ipc_channel_t *ch, const mimix_ipc_desc_t *desc,
+		unsigned int rights);
+int mimix_ipc_release(mimix_ipc_channel_t *ch, mimix_ipc_cap_t cap);
+int mimix_ipc_revoke(mimix_ipc_channel_t *ch, mimix_ipc_cap_t cap);
+
+/* Messaging; recv with block == 0 fails with EAGAIN when empty */
+int mimix_ipc_send(mimix_ipc_channel_t *ch, const mimix_ipc_desc_t *desc);
+int mimix_ipc_recv(mimix_ipc_channel_t *ch, mimix_ipc_desc_t *desc,
+		int block);
+
+/* Bounded recv: timeout_ms < 0 waits forever, 0 polls like block == 0,
+ * otherwise fails with ETIMEDOUT; how a caller notices a dead peer
+ */
+int mimix_ipc_recv_timed(mimix_ipc_channel_t *ch, mimix_ipc_desc_t *desc,
+		long timeout_ms);
+
+#endif /* _MIMIX_IPC_H */
@@ -0,0 +1,37 @@
+/* LZ Codec Header for MIMIX 3.1.2
+ *
+ * Functional Paradigm: Pure buffer-to-buffer transforms, no allocation
+ * Big O Complexity: O(n) compress and decompress
+ * Memory Optimization: 32-byte match extension with AVX2 compares
+ * Architecture: Byte-oriented LZ77 (LZ4-style sequences)
+ *
+ * A block is a series of sequences. Each starts with a token whose high
+ * nibble is the literal count and low nibble the match length minus
+ * MIMIX_LZ_MIN_MATCH; a nibble of 15 continues in 255-valued bytes. The
+ * literals follow, then a 16-bit little-endian offset back into the
+ * output. The final sequence carries literals only.
+ *
+ * Both functions return the number of bytes written, or -1 with errno
+ * set: ENOSPC when the output would exceed cap (compress uses this to
+ * reject incompressible input early), EINVAL for malformed input.
+ */
+
+#ifndef _MIMIX_LZ_H
+#define _MIMIX_LZ_H
+
+#include <headers/ansi.h>  /* Must precede system headers, see _POSIX_SOURCE */
+#include <stddef.h>
+
+#define MIMIX_LZ_MAX_INPUT   65535  /* Offsets and hash entries are 16-bit */
+#define MIMIX_LZ_MIN_MATCH   4
+#define MIMIX_LZ_HASH_BITS   12
+
+/* Worst-case output for n input bytes */
+#define MIMIX_LZ_BOUND(n)    ((n) + (n) / 255 + 16)
+
+long mimix_lz_compress(const unsigned char *src, size_t len,
+		unsigned char *dst, size_t cap);
+long mimix_lz_decompress(const unsigned char *src, size_t len,
+		unsigned char *dst, size_t cap);
+
+#endif /* _MIMIX_LZ_H */
@@ -0,0 +1,144 @@
+/* Paging Header for MIMIX 3.1.2 Microkernel
+ *
+ * Functional Paradigm: Radix translation with a tagged translation cache
+ * Big O Complexity: O(1) TLB hit, O(4) table walk, O(n) range operations
+ * Memory Optimization: Table pages drawn from a pool, huge-page leaves
+ * Architecture: x86-64 style 4-level tables, 48-bit virtual addresses
+ *
+ * Hosted model of the structures behind init_paging and process.page_dir.
+ * Tables live in a page pool and are linked by pool-relative physical
+ * addresses, so a whole address space is relocatable. A leaf may sit at
+ * level 0 (4 KiB), level 1 (2 MiB) or level 2 (1 GiB); mapping a range
+ * with MIMIX_PT_ALLOW_HUGE uses the largest leaf that alignment permits,
+ * and unmap/protect split a huge leaf they only partly cover.
+ *
+ * The software TLB is set-associative per page size and tags entries
+ * with the address space's ASID, so switching spaces needs no flush.
+ * Unmap and protect queue invalidations in a batch that is applied to
+ * every TLB in one shootdown; a batch that overflows flushes the ASID.
+ *
+ * Functions return 0 on success and -1 with errno set on failure.
+ */
+
+#ifndef _MIMIX_PAGING_H
+#define _MIMIX_PAGING_H
+
+#include <headers/ansi.h>  /* Must precede system headers, see _POSIX_SOURCE */
+
+/* Geometry */
+#define MIMIX_PAGE_SHIFT       12
+#define MIMIX_PAGE_SIZE        (1UL << MIMIX_PAGE_SHIFT)
+#define MIMIX_PT_LEVELS        4
+#define MIMIX_PT_ENTRIES       512
+#define MIMIX_PT_INDEX_BITS    9
+#define MIMIX_PT_VA_BITS       48
+#define MIMIX_PT_HUGE_LEVELS   3     /* Leaf levels: 4 KiB, 2 MiB, 1 GiB */
+
+/* Page Table Entry Bits */
+#define MIMIX_PTE_PRESENT      0x001UL
+#define MIMIX_PTE_WRITE        0x002UL
+#define MIMIX_PTE_USER         0x004UL
+#define MIMIX_PTE_HUGE         0x080UL  /* Leaf above level 0 */
+#define MIMIX_PTE_GLOBAL       0x100UL  /* Matches every ASID */
+#define MIMIX_PTE_NX           (1UL << 63)
+#define MIMIX_PTE_ADDR         0x000FFFFFFFFFF000UL
+#define MIMIX_PTE_PERMS        (MIMIX_PTE_WRITE | MIMIX_PTE_USER \
+                                | MIMIX_PTE_GLOBAL | MIMIX_PTE_NX)
+
+/* Mapping flag (software bit, never stored) */
+#define MIMIX_PT_ALLOW_HUGE    0x200UL
+
+/* TLB Geometry */
+#define MIMIX_TLB_SETS         64    /* Per page size (2^n) */
+#define MIMIX_TLB_WAYS         4
+#define MIMIX_TLB_BATCH        32    /* Queued pages before a full flush */
+
+/* Access Types */
+#define MIMIX_TLB_READ         0
+#define MIMIX_TLB_WRITE        1
+#define MIMIX_TLB_EXEC         2
+
+/* Page Pool: page-aligned arena of table pages */
+typedef struct mimix_page_pool {
+	unsigned char *base;
+	unsigned long npages;
+	unsigned long nfree;
+	unsigned int *free_stack;         /* Indices of free pages */
+} mimix_page_pool_t;
+
+/* Address Space */
+typedef struct mimix_pt_space {
+	mimix_page_pool_t *pool;
+	unsigned long root;               /* Pool address of the level 3 table */
+	unsigned int asid;
+	unsigned long tables;             /* Table pages in use */
+	unsigned long walks;              /* Full table walks performed */
+} mimix_pt_space_t;
+
+/* Pending Invalidations for one ASID */
+typedef struct mimix_tlb_batch {
+	unsigned int asid;
+	unsigned int count;
+	int overflow;                     /* Flush the whole ASID instead */
+	unsigned long va[MIMIX_TLB_BATCH];
+	unsigned int shift[MIMIX_TLB_BATCH];
+} mimix_tlb_batch_t;
+
+/* TLB Entry */
+typedef struct mimix_tlb_entry {
+	unsigned long vpn;                /* va >> page shift */
+	unsigned long pte;                /* Cached leaf, 0 if invalid */
+	unsigned int asid;
+	unsigned int _reserved;
+} mimix_tlb_entry_t;
+
+/* TLB Counters */
+typedef struct mimix_tlb_stats {
+	unsigned long hits;
+	unsigned long misses;
+	unsigned long faults;             /* Unmapped or permission denied */
+	unsigned long invalidations;      /* Entries dropped by shootdowns */
+	unsigned long flushes;            /* Whole-ASID flushes */
+	unsigned long shootdowns;         /* Batches received (IPIs) */
+} mimix_tlb_stats_t;
+
+/* Software TLB, one per simulated CPU */
+typedef struct mimix_tlb {
+	mimix_tlb_entry_t entries[MIMIX_PT_HUGE_LEVELS][MIMIX_TLB_SETS]
+			[MIMIX_TLB_WAYS];
+	unsigned char hand[MIMIX_PT_HUGE_LEVELS][MIMIX_TLB_SETS];
+	mimix_tlb_stats_t stats;
+} mimix_tlb_t;
+
+/* Page pool */
+int mimix_page_pool_init(mimix_page_pool_t *pool, unsigned long npages);
+void mimix_page_pool_destroy(mimix_page_pool_t *pool);
+
+/* Map saved table pages from fd at offset (page aligned), copy-on-write */
+int mimix_page_pool_restore(mimix_page_pool_t *pool, int fd,
+		unsigned long offset, unsigned long npages,
+		const unsigned int *free_stack, unsigned long nfree);
+
+/* Address spaces; va, pa and len must be page aligned */
+int mimix_pt_init(mimix_pt_space_t *space, mimix_page_pool_t *pool,
+		unsigned int asid);
+void mimix_pt_destroy(mimix_pt_space_t *space);
+int mimix_pt_map(mimix_pt_space_t *space, unsigned long va, unsigned long pa,
+		unsigned long len, unsigned long flags);
+int mimix_pt_unmap(mimix_pt_space_t *space, unsigned long va,
+		unsigned long len, mimix_tlb_batch_t *batch);
+int mimix_pt_protect(mimix_pt_space_t *space, unsigned long va,
+		unsigned long len, unsigned long flags, mimix_tlb_batch_t *batch);
+int mimix_pt_walk(mimix_pt_space_t *space, unsigned long va,
+		unsigned long *pte, unsigned int *shift);
+
+/* Software TLB */
+void mimix_tlb_init(mimix_tlb_t *tlb);
+int mimix_tlb_translate(mimix_tlb_t *tlb, mimix_pt_space_t *space,
+		unsigned long va, int access, unsigned long *pa);
+void mimix_tlb_flush_asid(mimix_tlb_t *tlb, unsigned int asid);
+void mimix_tlb_batch_init(mimix_tlb_batch_t *batch, unsigned int asid);
+void mimix_tlb_shootdown(mimix_tlb_t *tlbs, int ntlbs,
+		mimix_tlb_batch_t *batch);
+
+#endif /* _MIMIX_PAGING_H */
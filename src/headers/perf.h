@@ -0,0 +1,78 @@
+/* Hardware Performance Counter Header for MIMIX 3.1.2 Microkernel
+ *
+ * Functional Paradigm: Counter groups opened once, sampled around each case
+ * Big O Complexity: O(1) - One group read per begin/end pair
+ * Memory Optimization: Group state and samples are cache-line aligned
+ * Architecture: Linux perf_event_open(2), degrades to wall time only
+ *
+ * Counters are opened as a single group so they are scheduled onto the
+ * PMU together and can be read with one read(2). Members the PMU refuses
+ * are dropped individually; if the leader itself cannot be opened the
+ * group is marked unavailable and only wall-clock time is recorded.
+ */
+
+#ifndef _MIMIX_PERF_H
+#define _MIMIX_PERF_H
+
+#include <headers/ansi.h>  /* Must precede system headers, see _POSIX_SOURCE */
+#include <stdio.h>
+
+/* Counter Indices - Group leader first */
+#define MIMIX_PERF_CYCLES          0
+#define MIMIX_PERF_INSTRUCTIONS    1
+#define MIMIX_PERF_L1D_MISSES      2
+#define MIMIX_PERF_LLC_MISSES      3
+#define MIMIX_PERF_BRANCH_MISSES   4
+#define MIMIX_PERF_DTLB_MISSES     5
+#define MIMIX_PERF_NCOUNTERS       6
+
+/* Counter Group State
+ * fd[i] is -1 for counters that could not be opened.
+ */
+typedef struct mimix_perf_group {
+	int fd[MIMIX_PERF_NCOUNTERS];     /* Counter descriptors, leader is fd[0] */
+	unsigned long id[MIMIX_PERF_NCOUNTERS]; /* Kernel ids for group reads */
+	unsigned long opened_mask;        /* Bit i set when counter i is live */
+	int available;                    /* Non-zero when the leader opened */
+	unsigned long start_ns;           /* CLOCK_MONOTONIC at begin */
+} _CACHE_ALIGN mimix_perf_group_t;
+
+/* Per-Case Counter Sample
+ * Values are scaled by time_enabled/time_running when the kernel had to
+ * multiplex the group. valid_mask mirrors opened_mask of the group.
+ */
+typedef struct mimix_perf_sample {
+	unsigned long value[MIMIX_PERF_NCOUNTERS];
+	unsigned long valid_mask;
+	unsigned long wall_ns;
+	int multiplexed;                  /* Non-zero if values were scaled */
+} _CACHE_ALIGN mimix_perf_sample_t;
+
+/* Group lifecycle
+ * mimix_perf_open returns the number of counters opened (0 if unavailable).
+ */
+int mimix_perf_open(mimix_perf_group_t *group);
+void mimix_perf_close(mimix_perf_group_t *group);
+
+/* Sampling: reset and enable in begin, disable and read in end */
+void mimix_perf_begin(mimix_perf_group_t *group);
+void mimix_perf_end(mimix_perf_group_t *group, mimix_perf_sample_t *sample);
+
+/* Derived metrics: return negative values when inputs are unavailable */
+double mimix_perf_ipc(const mimix_perf_sample_t *sample) _NO_SIDE_EFFECTS;
+double mimix_perf_mpki(const mimix_perf_sample_t *sample, int counter)
+		_NO_SIDE_EFFECTS;
+
+/* Coarse classification: "memory", "compute" or "-" when counters are missing
+ * Memory-bound means low IPC together with high LLC or dTLB miss pressure.
+ */
+const char *mimix_perf_boundness(const mimix_perf_sample_t *sample)
+		_NO_SIDE_EFFECTS;
+
+/* Reporting */
+const char *mimix_perf_counter_name(int counter) _PURE_FUNCTION;
+void mimix_perf_print_header(FILE *out);
+void mimix_perf_print_row(FILE *out, const char *name,
+		const mimix_perf_sample_t *sample);
+
+#endif /* _MIMIX_PERF_H */
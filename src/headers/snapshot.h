@@ -0,0 +1,127 @@
+/* Kernel-State Snapshot Header for MIMIX 3.1.2 Microkernel
+ *
+ * Functional Paradigm: Boot state written once, mapped on every later boot
+ * Big O Complexity: O(1) open, O(n) checksum per section on first lookup
+ * Memory Optimization: Page-aligned sections mapped copy-on-write, no copies
+ * Architecture: Self-describing image: header, section table, section data
+ *
+ * An image holds the state that boot otherwise rebuilds (the table page
+ * pool and the address spaces behind init_paging, plus any caller
+ * tables) as a list of sections. Offsets are relative to the image
+ * start and the paging state is already pool-relative, so an image
+ * restores at whatever address it is mapped to.
+ *
+ * Images are written to "<path>.tmp" and renamed into place, so a reader
+ * never sees a partial image. Open checks the header checksum, the
+ * format version, the caller's build stamp and a layout fingerprint the
+ * library computes from the record sizes, the MIMIX_PTE_* bits and the
+ * table geometry, so an image whose tables this build would misread is
+ * stale even when the stamp matches. A section's checksum is checked the
+ * first time it is looked up. The expected boot sequence is
+ *
+ *     if (mimix_snap_open(&snap, path, MIMIX_BUILD_ID) != 0
+ *             || mimix_snap_restore_paging(&snap, &pool, spaces, n) != 0)
+ *         cold init, then mimix_snap_save_paging() into a new image
+ *
+ * A restored pool maps its table pages from the image file copy-on-write
+ * and keeps that mapping after the image is closed.
+ *
+ * Functions return 0 on success and -1 with errno set on failure:
+ * ESTALE for an image from another build or format, EBADMSG for a
+ * damaged one, ENOENT for a missing file or section.
+ */
+
+#ifndef _MIMIX_SNAPSHOT_H
+#define _MIMIX_SNAPSHOT_H
+
+#include <headers/paging.h>  /* Must precede system headers, see _POSIX_SOURCE */
+
+/* Image Format */
+#define MIMIX_SNAP_MAGIC       0x50414E53584D494DUL  /* "MIMXSNAP" */
+#define MIMIX_SNAP_VERSION     2
+#define MIMIX_SNAP_MAX_SECTIONS 16
+#define MIMIX_SNAP_ALIGN       MIMIX_PAGE_SIZE  /* Sections map in place */
+#define MIMIX_SNAP_PATH_MAX    256
+
+/* Build stamp; the Makefile passes the git revision */
+#ifndef MIMIX_BUILD_ID
+#define MIMIX_BUILD_ID         0UL
+#endif
+
+/* Section Identifiers; user sections start at MIMIX_SNAP_USER */
+#define MIMIX_SNAP_POOL_PAGES  1     /* Table pages, pool order */
+#define MIMIX_SNAP_POOL_FREE   2     /* Free stack of the pool */
+#define MIMIX_SNAP_SPACES      3     /* mimix_snap_space_t records */
+#define MIMIX_SNAP_USER        64
+
+/* Section Table Entry - 32 bytes */
+typedef struct mimix_snap_section {
+	unsigned long offset;             /* From image start, page aligned */
+	unsigned long length;
+	unsigned long checksum;
+	unsigned int id;
+	unsigned int _reserved;
+} mimix_snap_section_t;
+
+/* Image Header, first page of the file */
+typedef struct mimix_snap_header {
+	unsigned long magic;
+	unsigned long build;              /* Caller's stamp; a mismatch is stale */
+	unsigned long layout;             /* Writer's layout fingerprint */
+	unsigned long size;               /* Whole image */
+	unsigned long checksum;           /* Header with this field zeroed */
+	unsigned int version;
+	unsigned int page_size;
+	unsigned int nsections;
+	unsigned int _reserved;
+	mimix_snap_section_t sections[MIMIX_SNAP_MAX_SECTIONS];
+} mimix_snap_header_t;
+
+/* Address Space Record, pointer-free form of mimix_pt_space_t */
+typedef struct mimix_snap_space {
+	unsigned long root;
+	unsigned long tables;
+	unsigned int asid;
+	unsigned int _reserved;
+} mimix_snap_space_t;
+
+/* Image Writer */
+typedef struct mimix_snap_writer {
+	int fd;
+	unsigned long offset;             /* Where the next section goes */
+	mimix_snap_header_t header;
+	char path[MIMIX_SNAP_PATH_MAX];
+	char tmp[MIMIX_SNAP_PATH_MAX + 4];
+} mimix_snap_writer_t;
+
+/* Mapped Image */
+typedef struct mimix_snap {
+	int fd;                           /* Kept open for in-place mappings */
+	unsigned char *base;
+	unsigned long size;
+	const mimix_snap_header_t *header;
+	unsigned int verified;            /* Bit per section already checked */
+} mimix_snap_t;
+
+/* Writing: create, add sections, then commit or abort */
+int mimix_snap_create(mimix_snap_writer_t *w, const char *path,
+		unsigned long build);
+int mimix_snap_write(mimix_snap_writer_t *w, unsigned int id,
+		const void *data, unsigned long len);
+int mimix_snap_commit(mimix_snap_writer_t *w);
+void mimix_snap_abort(mimix_snap_writer_t *w);
+
+/* Reading */
+int mimix_snap_open(mimix_snap_t *snap, const char *path, unsigned long build);
+const void *mimix_snap_section(mimix_snap_t *snap, unsigned int id,
+		unsigned long *len);
+void mimix_snap_close(mimix_snap_t *snap);
+
+/* Paging state: the pool and the spaces drawn from it */
+int mimix_snap_save_paging(mimix_snap_writer_t *w,
+		const mimix_page_pool_t *pool, const mimix_pt_space_t *spaces,
+		int nspaces);
+int mimix_snap_restore_paging(mimix_snap_t *snap, mimix_page_pool_t *pool,
+		mimix_pt_space_t *spaces, int nspaces);
+
+#endif /* _MIMIX_SNAPSHOT_H */
@@ -0,0 +1,106 @@
+/* Streaming I/O Header for MIMIX 3.1.2 Microkernel
+ *
+ * Functional Paradigm: Readers hand out immutable slices, never copies
+ * Big O Complexity: O(1) per slice, O(n) bytes moved only by the kernel
+ * Memory Optimization: 32-byte aligned I/O buffers, page-aligned slices
+ * Architecture: mmap(2) with madvise(2), or a pread(2) thread pool
+ *
+ * Readers map the file with MADV_SEQUENTIAL and roll MADV_WILLNEED one
+ * chunk ahead of the consumer. Files above MIMIX_STREAM_MAP_LIMIT (or when
+ * MIMIX_STREAM_FORCE_PREAD is given) are instead read by a small pool of
+ * pread workers into a ring of aligned slots, so the next chunks are
+ * in flight while the consumer holds the current one. Either way the
+ * consumer sees a mimix_slice_t that stays valid until the next call.
+ *
+ * Writers coalesce small writes into one aligned buffer and bypass it for
+ * writes at least as large as the buffer.
+ *
+ * All functions return 0 (or a slice count) on success and -1 with errno
+ * set on failure.
+ */
+
+#ifndef _MIMIX_STREAM_H
+#define _MIMIX_STREAM_H
+
+#include <headers/limits.h>  /* Must precede system headers, see _POSIX_SOURCE */
+#include <stddef.h>
+#include <pthread.h>
+
+/* Stream Geometry */
+#define MIMIX_STREAM_CHUNK         (4 * 1024 * 1024)  /* Default slice size */
+#define MIMIX_STREAM_MAP_LIMIT     (32UL * 1024 * 1024 * 1024)  /* 32GB */
+#define MIMIX_STREAM_IO_THREADS    2   /* pread workers per reader */
+#define MIMIX_STREAM_IO_SLOTS      4   /* Double buffering per worker */
+#define MIMIX_STREAM_WRITE_BUFFER  MIMIX_PIPE_MAX  /* One flush fills a pipe */
+
+/* Reader Open Flags */
+#define MIMIX_STREAM_AUTO          0
+#define MIMIX_STREAM_FORCE_MMAP    1
+#define MIMIX_STREAM_FORCE_PREAD   2
+
+/* Reader Modes */
+#define MIMIX_STREAM_MODE_MMAP     1
+#define MIMIX_STREAM_MODE_PREAD    2
+
+/* Zero-Copy Slice: valid until the next mimix_stream_next or close */
+typedef struct mimix_slice {
+	const unsigned char *data;
+	size_t len;
+	unsigned long offset;             /* File offset of data[0] */
+} mimix_slice_t;
+
+/* pread Ring Slot */
+typedef struct mimix_stream_slot {
+	unsigned char *data;              /* _MIMIX_ALIGNMENT aligned */
+	size_t len;
+	unsigned long seq;                /* Chunk number held */
+	int state;                        /* Empty, filling or ready */
+} mimix_stream_slot_t;
+
+/* Sequential Reader */
+typedef struct mimix_stream_reader {
+	int fd;
+	int mode;                         /* MIMIX_STREAM_MODE_* */
+	unsigned long size;
+	size_t chunk;
+	unsigned long nchunks;
+	unsigned long next_read;          /* Next chunk handed to the consumer */
+
+	/* mmap mode */
+	const unsigned char *map;
+
+	/* pread mode */
+	pthread_mutex_t lock;
+	pthread_cond_t filled;
+	pthread_cond_t drained;
+	pthread_t threads[MIMIX_STREAM_IO_THREADS];
+	int nthreads;
+	mimix_stream_slot_t slots[MIMIX_STREAM_IO_SLOTS];
+	unsigned long next_fill;          /* Next chunk claimed by a worker */
+	int held;                         /* Slot lent to the consumer or -1 */
+	int stop;
+	int error;                        /* First worker errno */
+} mimix_stream_reader_t;
+
+/* Coalescing Writer */
+typedef struct mimix_stream_writer {
+	int fd;
+	unsigned char *buf;               /* _MIMIX_ALIGNMENT aligned */
+	size_t cap;
+	size_t len;
+	unsigned long written;            /* Bytes accepted so far */
+} mimix_stream_writer_t;
+
+/* Reader interface; chunk 0 selects MIMIX_STREAM_CHUNK */
+int mimix_stream_open(mimix_stream_reader_t *r, const char *path, int flags,
+		size_t chunk);
+int mimix_stream_next(mimix_stream_reader_t *r, mimix_slice_t *slice);
+void mimix_stream_close(mimix_stream_reader_t *r);
+
+/* Writer interface */
+int mimix_stream_writer_open(mimix_stream_writer_t *w, const char *path);
+int mimix_stream_write(mimix_stream_writer_t *w, const void *data, size_t len);
+int mimix_stream_flush(mimix_stream_writer_t *w);
+int mimix_stream_writer_close(mimix_stream_writer_t *w);
+
+#endif /* _MIMIX_STREAM_H */
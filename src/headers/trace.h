@@ -0,0 +1,137 @@
+/* Hot-Path Tracing Header for MIMIX 3.1.2 Microkernel
+ *
+ * Functional Paradigm: Append-only per-thread event logs
+ * Big O Complexity: O(1) - One rdtsc and two stores per event
+ * Memory Optimization: Cache-aligned per-thread ring buffers, no sharing
+ * Architecture: x86_64 TSC, calibrated to nanoseconds at startup
+ *
+ * Build with -D_MIMIX_TRACE to enable the annotation macros; without it
+ * they expand to nothing and cost nothing. Event names are stored by
+ * pointer and must be string literals (or otherwise outlive the export).
+ *
+ *   _TRACE_SCOPE(name)   Declaration: begin now, end when the block exits.
+ *                        At most one per block, placed with the declarations.
+ *   _TRACE_BEGIN(name)   Statement: open an event explicitly.
+ *   _TRACE_END(name)     Statement: close it.
+ */
+
+#ifndef _MIMIX_TRACE_H
+#define _MIMIX_TRACE_H
+
+#include <headers/ansi.h>  /* Must precede system headers, see _POSIX_SOURCE */
+#include <stddef.h>
+
+/* Ring capacity per thread (power of two); oldest events are overwritten */
+#define MIMIX_TRACE_BUFFER_EVENTS  32768
+#define MIMIX_TRACE_PHASE_BEGIN    'B'
+#define MIMIX_TRACE_PHASE_END      'E'
+
+#ifndef _THREAD_LOCAL
+#define _THREAD_LOCAL
+#endif
+
+/* Trace Event Record - 16 bytes, four per cache line
+ * stamp holds the raw TSC shifted left by one with the end flag in bit 0.
+ */
+typedef struct mimix_trace_event {
+	unsigned long stamp;              /* (tsc << 1) | is_end */
+	const char *name;                 /* Static event name */
+} mimix_trace_event_t;
+
+/* Per-Thread Event Buffer
+ * Only the owning thread writes; head is published with release order so
+ * an exporter on another thread sees complete events.
+ */
+typedef struct mimix_trace_buffer {
+	unsigned long head;               /* Events ever written */
+	unsigned long tid;                /* Kernel thread id */
+	struct mimix_trace_buffer *next;  /* Global registration list */
+	mimix_trace_event_t events[MIMIX_TRACE_BUFFER_EVENTS];
+} _CACHE_ALIGN mimix_trace_buffer_t;
+
+/* Runtime interface (always compiled into the library)
+ * mimix_trace_shutdown frees every buffer; call it only after all tracing
+ * threads have exited.
+ */
+int mimix_trace_init(void);
+unsigned long mimix_trace_clock_ns(void);
+mimix_trace_buffer_t *mimix_trace_attach(void) _COLD;
+int mimix_trace_export_chrome(const char *path);
+unsigned long mimix_trace_overwritten(void);
+double mimix_trace_ns_per_tick(void);
+void mimix_trace_shutdown(void);
+
+extern _THREAD_LOCAL mimix_trace_buffer_t *mimix_trace_tls;
+
+#ifdef __GNUC__
+
+/* Read the timestamp counter
+ * Complexity: O(1) - Single instruction, not serialising
+ */
+#if defined(__x86_64__) || defined(__amd64__)
+static _ALWAYS_INLINE unsigned long mimix_trace_rdtsc(void) {
+	unsigned int lo, hi;
+
+	__asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+	return ((unsigned long) hi << 32) | lo;
+}
+#else
+#define mimix_trace_rdtsc() mimix_trace_clock_ns()
+#endif
+
+/* Append one event to the calling thread's buffer
+ * Complexity: O(1) - Lock-free, no atomics beyond a release store
+ */
+static _ALWAYS_INLINE void mimix_trace_record(const char *name,
+		unsigned long phase) {
+	mimix_trace_buffer_t *buf = mimix_trace_tls;
+	mimix_trace_event_t *ev;
+	unsigned long head;
+
+	if (_UNLIKELY(buf == NULL)) {
+		buf = mimix_trace_attach();
+	}
+	head = buf->head;
+	ev = &buf->events[head & (MIMIX_TRACE_BUFFER_EVENTS - 1)];
+	ev->stamp = (mimix_trace_rdtsc() << 1)
+			| (phase == MIMIX_TRACE_PHASE_END ? 1UL : 0UL);
+	ev->name = name;
+	__atomic_store_n(&buf->head, head + 1, __ATOMIC_RELEASE);
+}
+
+/* Scope helpers used by _TRACE_SCOPE via the cleanup attribute */
+static _ALWAYS_INLINE const char *mimix_trace_scope_enter(const char *name) {
+	mimix_trace_record(name, MIMIX_TRACE_PHASE_BEGIN);
+	return name;
+}
+
+static _ALWAYS_INLINE void mimix_trace_scope_exit(const char **name) {
+	mimix_trace_record(*name, MIMIX_TRACE_PHASE_END);
+}
+
+#endif /* __GNUC__ */
+
+/* Annotation Macros */
+#if defined(_MIMIX_TRACE) && defined(__GNUC__)
+
+#define _TRACE_BEGIN(name) mimix_trace_record((name), MIMIX_TRACE_PHASE_BEGIN)
+#define _TRACE_END(name)   mimix_trace_record((name), MIMIX_TRACE_PHASE_END)
+#define _TRACE_SCOPE(name) \
+    const char *_mimix_trace_scope \
+        __attribute__((cleanup(mimix_trace_scope_exit), unused)) = \
+        mimix_trace_scope_enter(name)
+
+#else  /* !_MIMIX_TRACE */
+
+#define _TRACE_BEGIN(name) ((void)0)
+#define _TRACE_END(name)   ((void)0)
+#ifdef __GNUC__
+#define _TRACE_SCOPE(name) \
+    extern int mimix_trace_scope_disabled __attribute__((unused))
+#else
+#define _TRACE_SCOPE(name) extern int mimix_trace_scope_disabled
+#endif
+
+#endif /* _MIMIX_TRACE */
+
+#endif /* _MIMIX_TRACE_H */
@@ -0,0 +1,92 @@
+/* Compressed Page Store Header for MIMIX 3.1.2 Microkernel
+ *
+ * Functional Paradigm: Page index -> compressed object, decompressed on load
+ * Big O Complexity: O(PAGE) store and load, O(1) same-filled pages
+ * Memory Optimization: Size-class pools, 16-byte slots, no per-object malloc
+ * Architecture: LZ codec (lz.h) over zsmalloc-style class spans
+ *
+ * A store backs the memory manager when it would otherwise fail with
+ * NULL: cold pages are handed in by index and reclaimed on demand.
+ * Pages made of one repeated word are recorded by value and use no pool
+ * memory. Other pages are compressed into the smallest size class that
+ * fits; a page that does not shrink below MIMIX_ZRAM_MAX_OBJECT is kept
+ * raw in the page-sized class. Each class carves fixed chunks out of
+ * MIMIX_ZRAM_SPAN-byte spans and recycles them through a free list;
+ * spans are retained for reuse until the store is destroyed.
+ *
+ * Pages are word aligned. A store is not internally locked; callers
+ * serialise access to it.
+ * Functions return 0 on success and -1 with errno set on failure.
+ */
+
+#ifndef _MIMIX_ZRAM_H
+#define _MIMIX_ZRAM_H
+
+#include <headers/lz.h>  /* Must precede system headers, see _POSIX_SOURCE */
+
+/* Store Geometry */
+#define MIMIX_ZRAM_PAGE        4096
+#define MIMIX_ZRAM_CLASS_STEP  64    /* Chunk size granularity */
+#define MIMIX_ZRAM_CLASSES     (MIMIX_ZRAM_PAGE / MIMIX_ZRAM_CLASS_STEP)
+#define MIMIX_ZRAM_SPAN        (64 * 1024)  /* Pool growth unit */
+#define MIMIX_ZRAM_MAX_OBJECT  (3 * MIMIX_ZRAM_PAGE / 4)  /* Else store raw */
+
+/* Slot Flags */
+#define MIMIX_ZRAM_EMPTY       0
+#define MIMIX_ZRAM_SAME        1     /* u.fill repeats across the page */
+#define MIMIX_ZRAM_COMPRESSED  2
+#define MIMIX_ZRAM_RAW         3     /* Incompressible, stored verbatim */
+
+/* Page Slot - 16 bytes */
+typedef struct mimix_zram_slot {
+	union {
+		unsigned char *object;        /* Chunk in a class pool */
+		unsigned long fill;           /* Same-filled word */
+	} u;
+	unsigned short length;            /* Object bytes */
+	unsigned char size_class;
+	unsigned char flags;              /* MIMIX_ZRAM_* */
+	unsigned int _reserved;
+} mimix_zram_slot_t;
+
+/* Size-Class Pool */
+typedef struct mimix_zram_class {
+	unsigned int chunk;               /* Bytes per object */
+	unsigned int per_span;            /* Chunks carved from one span */
+	unsigned char *free_list;         /* Linked through the free chunks */
+	unsigned char *spans;             /* Linked through each span's head */
+	unsigned long nspans;
+	unsigned long used;               /* Chunks handed out */
+} mimix_zram_class_t;
+
+/* Store Counters */
+typedef struct mimix_zram_stats {
+	unsigned long pages;              /* Pages held */
+	unsigned long same_filled;
+	unsigned long raw;                /* Incompressible pages */
+	unsigned long compressed_bytes;   /* Sum of object lengths */
+	unsigned long pool_bytes;         /* Span memory across all classes */
+} mimix_zram_stats_t;
+
+/* Compressed Store */
+typedef struct mimix_zram {
+	unsigned long npages;
+	mimix_zram_slot_t *slots;
+	mimix_zram_class_t classes[MIMIX_ZRAM_CLASSES];
+	mimix_zram_stats_t stats;
+	unsigned char buffer[MIMIX_LZ_BOUND(MIMIX_ZRAM_PAGE)];
+} mimix_zram_t;
+
+int mimix_zram_init(mimix_zram_t *zram, unsigned long npages);
+void mimix_zram_destroy(mimix_zram_t *zram);
+
+/* Page transfer; store replaces whatever the index held */
+int mimix_zram_store(mimix_zram_t *zram, unsigned long index,
+		const void *page);
+int mimix_zram_load(mimix_zram_t *zram, unsigned long index, void *page);
+void mimix_zram_discard(mimix_zram_t *zram, unsigned long index);
+
+/* Bytes the store occupies: pools plus slot table */
+unsigned long mimix_zram_memory_used(const mimix_zram_t *zram);
+
+#endif /* _MIMIX_ZRAM_H */
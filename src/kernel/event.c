@@ -0,0 +1,376 @@
+/* Event Dispatch Loop for MIMIX 3.1.2
+ *
+ * Functional Paradigm: Level-triggered readiness, drain-then-dispatch
+ * Big O Complexity: O(r log r) per pass - r ready vectors, one read each
+ * Architecture: epoll(7) over eventfd(2), timerfd(2) and signalfd(2)
+ *
+ * Every source counts on its own: eventfd and timerfd read back the
+ * number of raises or expirations, signalfd yields one record per queued
+ * signal. Deferring the read therefore merges events for free, which is
+ * what the hold-off exploits.
+ */
+
+#include <headers/event.h>
+#include <headers/trace.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/prctl.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+
+#define MIMIX_EVENT_SIGNAL_BATCH 16    /* signalfd records per read */
+#define MIMIX_EVENT_WAKE         MIMIX_EVENT_VECTORS  /* epoll tag of wake */
+#define MIMIX_EVENT_SLACK_NS     1UL   /* Timer slack while coalescing */
+
+int mimix_event_init(mimix_event_loop_t *loop, unsigned long holdoff_max_ns) {
+	struct epoll_event ev;
+	int i;
+
+	memset(loop, 0, sizeof(*loop));
+	for (i = 0; i < MIMIX_EVENT_VECTORS; i++) {
+		loop->vectors[i].fd = -1;
+	}
+	loop->epfd = -1;
+	loop->wake.fd = -1;
+	/* The hold-off is one nanosleep; tv_nsec must stay below a second */
+	if (holdoff_max_ns > MIMIX_EVENT_HOLDOFF_LIMIT) {
+		errno = EINVAL;
+		return -1;
+	}
+	loop->holdoff_max_ns = holdoff_max_ns;
+	sigemptyset(&loop->blocked);
+	loop->wake.fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	loop->wake.kind = MIMIX_EVENT_SOURCE_EVENTFD;
+	loop->epfd = epoll_create1(EPOLL_CLOEXEC);
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.u32 = MIMIX_EVENT_WAKE;
+	if (loop->wake.fd < 0 || loop->epfd < 0
+			|| epoll_ctl(loop->epfd, EPOLL_CTL_ADD, loop->wake.fd, &ev) != 0) {
+		int saved = errno;
+
+		mimix_event_destroy(loop);
+		errno = saved;
+		return -1;
+	}
+	return 0;
+}
+
+/* Signals still queued for the loop are discarded, not delivered to the
+ * restored disposition (whose default for most signals is to terminate)
+ */
+void mimix_event_destroy(mimix_event_loop_t *loop) {
+	struct timespec zero;
+	int i;
+
+	for (i = 0; i < MIMIX_EVENT_VECTORS; i++) {
+		if (loop->vectors[i].fd >= 0) {
+			close(loop->vectors[i].fd);
+			loop->vectors[i].fd = -1;
+		}
+	}
+	if (loop->epfd >= 0) {
+		close(loop->epfd);
+		loop->epfd = -1;
+	}
+	if (loop->wake.fd >= 0) {
+		close(loop->wake.fd);
+		loop->wake.fd = -1;
+	}
+	zero.tv_sec = 0;
+	zero.tv_nsec = 0;
+	while (sigtimedwait(&loop->blocked, NULL, &zero) > 0) {
+		continue;  /* Drain before unblocking */
+	}
+	pthread_sigmask(SIG_UNBLOCK, &loop->blocked, NULL);
+	sigemptyset(&loop->blocked);
+}
+
+int mimix_event_register(mimix_event_loop_t *loop, unsigned int vector,
+		mimix_event_handler_t handler, void *arg) {
+	if (vector >= MIMIX_EVENT_VECTORS) {
+		errno = EINVAL;
+		return -1;
+	}
+	loop->vectors[vector].handler = handler;
+	loop->vectors[vector].arg = arg;
+	return 0;
+}
+
+/* Bind a freshly created descriptor to a free vector
+ * Complexity: O(1) - One epoll_ctl
+ */
+static int mimix_event_attach(mimix_event_loop_t *loop, unsigned int vector,
+		int fd, int kind) {
+	struct epoll_event ev;
+
+	if (fd < 0) {
+		return -1;
+	}
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.u32 = vector;
+	if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+		int saved = errno;
+
+		close(fd);
+		errno = saved;
+		return -1;
+	}
+	loop->vectors[vector].fd = fd;
+	loop->vectors[vector].kind = kind;
+	return 0;
+}
+
+/* Vector must exist and have no source yet
+ * Complexity: O(1)
+ */
+static int mimix_event_vector_free(mimix_event_loop_t *loop,
+		unsigned int vector) {
+	if (vector >= MIMIX_EVENT_VECTORS) {
+		errno = EINVAL;
+		return 0;
+	}
+	if (loop->vectors[vector].fd >= 0) {
+		errno = EBUSY;
+		return 0;
+	}
+	return 1;
+}
+
+int mimix_event_add_eventfd(mimix_event_loop_t *loop, unsigned int vector) {
+	if (!mimix_event_vector_free(loop, vector)) {
+		return -1;
+	}
+	return mimix_event_attach(loop, vector,
+			eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC), MIMIX_EVENT_SOURCE_EVENTFD);
+}
+
+int mimix_event_add_timer(mimix_event_loop_t *loop, unsigned int vector,
+		unsigned long period_ns) {
+	struct itimerspec spec;
+	int fd;
+
+	if (!mimix_event_vector_free(loop, vector)) {
+		return -1;
+	}
+	if (period_ns == 0) {
+		errno = EINVAL;
+		return -1;
+	}
+	fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (fd < 0) {
+		return -1;
+	}
+	spec.it_interval.tv_sec = (time_t) (period_ns / 1000000000UL);
+	spec.it_interval.tv_nsec = (long) (period_ns % 1000000000UL);
+	spec.it_value = spec.it_interval;
+	if (timerfd_settime(fd, 0, &spec, NULL) != 0) {
+		int saved = errno;
+
+		close(fd);
+		errno = saved;
+		return -1;
+	}
+	return mimix_event_attach(loop, vector, fd, MIMIX_EVENT_SOURCE_TIMERFD);
+}
+
+/* The signal is blocked in the calling thread; call before spawning
+ * threads so that none of them takes it asynchronously, and destroy the
+ * loop from the same thread so the mask is restored where it was changed.
+ */
+int mimix_event_add_signal(mimix_event_loop_t *loop, unsigned int vector,
+		int signo) {
+	sigset_t set, old;
+	int rc;
+
+	if (!mimix_event_vector_free(loop, vector)) {
+		return -1;
+	}
+	sigemptyset(&set);
+	if (sigaddset(&set, signo) != 0) {
+		return -1;
+	}
+	rc = pthread_sigmask(SIG_BLOCK, &set, &old);
+	if (rc != 0) {
+		errno = rc;
+		return -1;
+	}
+	if (mimix_event_attach(loop, vector,
+			signalfd(-1, &set, SFD_NONBLOCK | SFD_CLOEXEC),
+			MIMIX_EVENT_SOURCE_SIGNALFD) != 0) {
+		int saved = errno;
+
+		if (!sigismember(&old, signo)) {
+			pthread_sigmask(SIG_UNBLOCK, &set, NULL);
+		}
+		errno = saved;
+		return -1;
+	}
+	/* Already blocked by the caller: leave it blocked on destroy */
+	if (!sigismember(&old, signo)) {
+		sigaddset(&loop->blocked, signo);
+	}
+	return 0;
+}
+
+int mimix_event_raise(mimix_event_loop_t *loop, unsigned int vector,
+		unsigned long count) {
+	if (vector >= MIMIX_EVENT_VECTORS
+			|| loop->vectors[vector].kind != MIMIX_EVENT_SOURCE_EVENTFD) {
+		errno = EINVAL;
+		return -1;
+	}
+	return (write(loop->vectors[vector].fd, &count, sizeof(count))
+			== (ssize_t) sizeof(count)) ? 0 : -1;
+}
+
+/* Read everything pending on a vector
+ * Complexity: O(1) for counters, O(s) for s queued signals
+ */
+static unsigned long mimix_event_drain(mimix_event_vector_t *v) {
+	if (v->kind == MIMIX_EVENT_SOURCE_SIGNALFD) {
+		struct signalfd_siginfo info[MIMIX_EVENT_SIGNAL_BATCH];
+		unsigned long count = 0;
+		ssize_t got;
+
+		while ((got = read(v->fd, info, sizeof(info))) > 0) {
+			count += (unsigned long) got / sizeof(info[0]);
+		}
+		return count;
+	} else {
+		unsigned long count;
+
+		/* eventfd and timerfd reset their counter on read */
+		if (read(v->fd, &count, sizeof(count)) != (ssize_t) sizeof(count)) {
+			return 0;
+		}
+		return count;
+	}
+}
+
+/* Interrupt moderation: grow the hold-off under load, drop it when idle
+ * Complexity: O(1)
+ */
+static void mimix_event_adapt(mimix_event_loop_t *loop, unsigned long events) {
+	if (events >= MIMIX_EVENT_COALESCE_HIGH) {
+		loop->holdoff_ns = (loop->holdoff_ns == 0) ? MIMIX_EVENT_HOLDOFF_MIN
+				: 2 * loop->holdoff_ns;
+		if (loop->holdoff_ns > loop->holdoff_max_ns) {
+			loop->holdoff_ns = loop->holdoff_max_ns;
+		}
+	} else if (events <= MIMIX_EVENT_COALESCE_LOW) {
+		loop->holdoff_ns = 0;
+	}
+}
+
+int mimix_event_dispatch(mimix_event_loop_t *loop, int timeout_ms) {
+	struct epoll_event ready[MIMIX_EVENT_BATCH];
+	unsigned int order[MIMIX_EVENT_BATCH];
+	unsigned long total = 0;
+	int n, m, i, j;
+	_TRACE_SCOPE("event_dispatch");
+
+	n = epoll_wait(loop->epfd, ready, MIMIX_EVENT_BATCH, timeout_ms);
+	if (n <= 0) {
+		return (n < 0 && errno != EINTR) ? -1 : 0;
+	}
+
+	if (loop->holdoff_ns > 0) {
+		struct timespec delay;
+
+		/* Let more events land, then take a fresh readiness snapshot */
+		delay.tv_sec = 0;
+		delay.tv_nsec = (long) loop->holdoff_ns;
+		nanosleep(&delay, NULL);
+		n = epoll_wait(loop->epfd, ready, MIMIX_EVENT_BATCH, 0);
+		if (n < 0) {
+			return (errno != EINTR) ? -1 : 0;
+		}
+		loop->stats.holdoffs++;
+	}
+
+	/* Priority order: lower vectors first (insertion sort, n <= 64) */
+	for (i = 0, m = 0; i < n; i++) {
+		unsigned int vector = ready[i].data.u32;
+
+		if (vector == MIMIX_EVENT_WAKE) {
+			/* Only there to end the wait; run re-checks the stop flag */
+			mimix_event_drain(&loop->wake);
+			continue;
+		}
+		for (j = m; j > 0 && order[j - 1] > vector; j--) {
+			order[j] = order[j - 1];
+		}
+		order[j] = vector;
+		m++;
+	}
+
+	for (i = 0; i < m; i++) {
+		mimix_event_vector_t *v = &loop->vectors[order[i]];
+		unsigned long count = mimix_event_drain(v);
+
+		/* Spurious, or no handler: discarded like an unclaimed IRQ */
+		if (count == 0 || v->handler == NULL) {
+			continue;
+		}
+		v->handler(order[i], count, v->arg);
+		loop->stats.dispatches++;
+		total += count;
+	}
+
+	if (total > 0) {
+		loop->stats.passes++;
+		loop->stats.events += total;
+	}
+	if (loop->holdoff_max_ns > 0) {
+		mimix_event_adapt(loop, total);
+	}
+	return (total > (unsigned long) INT_MAX) ? INT_MAX : (int) total;
+}
+
+/* The default 50 us timer slack would stretch every 2-50 us hold-off to
+ * the limit or beyond, so the loop thread runs with 1 ns slack and gets
+ * its previous slack back on return
+ */
+int mimix_event_run(mimix_event_loop_t *loop) {
+	int slack = (loop->holdoff_max_ns > 0)
+			? prctl(PR_GET_TIMERSLACK, 0UL, 0UL, 0UL, 0UL) : -1;
+	int result = 0;
+
+	if (slack > 0) {
+		prctl(PR_SET_TIMERSLACK, MIMIX_EVENT_SLACK_NS, 0UL, 0UL, 0UL);
+	}
+	while (!__atomic_load_n(&loop->stop, __ATOMIC_ACQUIRE)) {
+		if (mimix_event_dispatch(loop, -1) < 0) {
+			result = -1;
+			break;
+		}
+	}
+	if (slack > 0) {
+		prctl(PR_SET_TIMERSLACK, (unsigned long) slack, 0UL, 0UL, 0UL);
+	}
+	if (result == 0) {
+		__atomic_store_n(&loop->stop, 0, __ATOMIC_RELAXED);
+	}
+	return result;
+}
+
+/* From a handler the flag alone suffices; from another thread the wake
+ * write ends an epoll_wait that would otherwise never return
+ */
+void mimix_event_stop(mimix_event_loop_t *loop) {
+	unsigned long one = 1;
+
+	__atomic_store_n(&loop->stop, 1, __ATOMIC_RELEASE);
+	if (write(loop->wake.fd, &one, sizeof(one)) != (ssize_t) sizeof(one)) {
+		return;  /* EAGAIN only: a wakeup is already pending */
+	}
+}
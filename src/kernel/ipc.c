@@ -0,0 +1,502 @@
+/* Shared-Memory IPC Transport for MIMIX 3.1.2
+ *
+ * Functional Paradigm: Descriptor passing over single-producer rings
+ * Big O Complexity: O(1) messaging, O(n/64) bitmap scan per grant
+ * Architecture: memfd_create(2), MAP_SHARED, process-shared futex(2)
+ *
+ * Ring wakeups follow the usual flag/fence protocol: a waiter publishes
+ * its waiters flag, re-checks the index and only then sleeps on it; the
+ * other side publishes the index, fences and wakes if the flag is set.
+ * Grant table and arena bitmap updates are serialised by a futex mutex
+ * living in the shared header.
+ */
+
+#include <headers/ipc.h>
+#include <headers/trace.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#define MIMIX_IPC_MAGIC          0x4D494D4958495043UL  /* "MIMIXIPC" */
+#define MIMIX_IPC_SPIN           128   /* Polls before sleeping */
+
+#define MIMIX_IPC_GRANT_FREE     0
+#define MIMIX_IPC_GRANT_LIVE     1
+#define MIMIX_IPC_GRANT_QUARANTINE 2
+
+#define MIMIX_IPC_RING_MASK      (MIMIX_IPC_RING_SLOTS - 1)
+#define MIMIX_IPC_BITS           (8 * sizeof(unsigned long))
+#define MIMIX_IPC_CAP_GEN(cap)   ((unsigned int) ((cap) >> 32))
+
+/* Process-shared futex operations (no FUTEX_PRIVATE_FLAG); timeout is
+ * relative, NULL sleeps until woken
+ * Complexity: O(1) - Single system call
+ */
+static void mimix_ipc_futex_wait(unsigned int *addr, unsigned int expected,
+		const struct timespec *timeout) {
+	syscall(SYS_futex, addr, FUTEX_WAIT, expected, timeout, NULL, 0);
+}
+
+static void mimix_ipc_futex_wake(unsigned int *addr) {
+	syscall(SYS_futex, addr, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+/* Three-state futex mutex: 0 free, 1 locked, 2 locked with waiters
+ * Complexity: O(1) uncontended - One CAS
+ */
+static void mimix_ipc_lock(unsigned int *lock) {
+	unsigned int c = 0;
+
+	if (__atomic_compare_exchange_n(lock, &c, 1, 0, __ATOMIC_ACQUIRE,
+			__ATOMIC_RELAXED)) {
+		return;
+	}
+	if (c != 2) {
+		c = __atomic_exchange_n(lock, 2, __ATOMIC_ACQUIRE);
+	}
+	while (c != 0) {
+		mimix_ipc_futex_wait(lock, 2, NULL);
+		c = __atomic_exchange_n(lock, 2, __ATOMIC_ACQUIRE);
+	}
+}
+
+static void mimix_ipc_unlock(unsigned int *lock) {
+	if (__atomic_fetch_sub(lock, 1, __ATOMIC_RELEASE) != 1) {
+		__atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+		syscall(SYS_futex, lock, FUTEX_WAKE, 1, NULL, NULL, 0);
+	}
+}
+
+/* Short spin before a futex sleep: pays off when the peer is running
+ * Complexity: O(MIMIX_IPC_SPIN)
+ */
+static int mimix_ipc_spin_until_changed(unsigned int *word,
+		unsigned int value) {
+	int i;
+
+	for (i = 0; i < MIMIX_IPC_SPIN; i++) {
+		if (__atomic_load_n(word, __ATOMIC_ACQUIRE) != value) {
+			return 1;
+		}
+		__asm__ __volatile__("pause");
+	}
+	return 0;
+}
+
+/* Map a region and derive local pointers
+ * Complexity: O(1)
+ */
+static int mimix_ipc_map_region(mimix_ipc_channel_t *ch, int fd, size_t size,
+		int side) {
+	void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+	if (base == MAP_FAILED) {
+		return -1;
+	}
+	ch->fd = fd;
+	ch->side = side;
+	ch->size = size;
+	ch->shm = (mimix_ipc_shared_t *) base;
+	return 0;
+}
+
+int mimix_ipc_create(mimix_ipc_channel_t *ch, size_t arena_bytes) {
+	mimix_ipc_shared_t *shm;
+	unsigned long blocks, header, bitmap, size;
+	int fd;
+
+	memset(ch, 0, sizeof(*ch));
+	ch->fd = -1;
+	if (arena_bytes == 0) {
+		arena_bytes = MIMIX_IPC_DEFAULT_ARENA;
+	}
+	blocks = (arena_bytes + MIMIX_IPC_BLOCK_SIZE - 1) / MIMIX_IPC_BLOCK_SIZE;
+	header = (sizeof(mimix_ipc_shared_t) + MIMIX_IPC_BLOCK_SIZE - 1)
+			& ~(unsigned long) (MIMIX_IPC_BLOCK_SIZE - 1);
+	bitmap = ((blocks + MIMIX_IPC_BITS - 1) / MIMIX_IPC_BITS)
+			* sizeof(unsigned long);
+	bitmap = (bitmap + MIMIX_IPC_BLOCK_SIZE - 1)
+			& ~(unsigned long) (MIMIX_IPC_BLOCK_SIZE - 1);
+	size = header + bitmap + blocks * MIMIX_IPC_BLOCK_SIZE;
+
+	fd = memfd_create("mimix-ipc", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (fd < 0) {
+		return -1;
+	}
+	/* Sealed size: a peer cannot truncate the region under us (SIGBUS) */
+	if (ftruncate(fd, (off_t) size) != 0
+			|| fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL)
+					!= 0 || mimix_ipc_map_region(ch, fd, size, 0) != 0) {
+		int saved = errno;
+
+		close(fd);
+		errno = saved;
+		return -1;
+	}
+
+	/* memfd pages start zeroed: rings empty, grants free, bitmap clear */
+	shm = ch->shm;
+	shm->region_size = size;
+	shm->bitmap_offset = header;
+	shm->arena_offset = header + bitmap;
+	shm->arena_blocks = blocks;
+	__atomic_store_n(&shm->magic, MIMIX_IPC_MAGIC, __ATOMIC_RELEASE);
+
+	ch->arena = (unsigned char *) shm + shm->arena_offset;
+	return 0;
+}
+
+/* Failed attach: the fd was handed over, so it is closed here too
+ * Complexity: O(1)
+ */
+static int mimix_ipc_attach_fail(mimix_ipc_channel_t *ch, int fd, int err) {
+	if (ch->shm != NULL) {
+		munmap(ch->shm, ch->size);
+	}
+	close(fd);
+	memset(ch, 0, sizeof(*ch));
+	ch->fd = -1;
+	errno = err;
+	return -1;
+}
+
+int mimix_ipc_attach(mimix_ipc_channel_t *ch, int fd, int side) {
+	struct stat st;
+
+	memset(ch, 0, sizeof(*ch));
+	ch->fd = -1;
+	if (side != 0 && side != 1) {
+		return mimix_ipc_attach_fail(ch, fd, EINVAL);
+	}
+	if (fstat(fd, &st) != 0) {
+		return mimix_ipc_attach_fail(ch, fd, errno);
+	}
+	if ((unsigned long) st.st_size < sizeof(mimix_ipc_shared_t)) {
+		return mimix_ipc_attach_fail(ch, fd, EPROTO);
+	}
+	if (mimix_ipc_map_region(ch, fd, (size_t) st.st_size, side) != 0) {
+		return mimix_ipc_attach_fail(ch, fd, errno);
+	}
+	if (__atomic_load_n(&ch->shm->magic, __ATOMIC_ACQUIRE) != MIMIX_IPC_MAGIC
+			|| ch->shm->region_size != (unsigned long) st.st_size
+			|| ch->shm->arena_offset
+					+ ch->shm->arena_blocks * MIMIX_IPC_BLOCK_SIZE
+					!= ch->shm->region_size) {
+		return mimix_ipc_attach_fail(ch, fd, EPROTO);
+	}
+	ch->arena = (unsigned char *) ch->shm + ch->shm->arena_offset;
+	return 0;
+}
+
+void mimix_ipc_detach(mimix_ipc_channel_t *ch) {
+	if (ch->shm != NULL) {
+		munmap(ch->shm, ch->size);
+	}
+	if (ch->fd >= 0) {
+		close(ch->fd);
+	}
+	memset(ch, 0, sizeof(*ch));
+	ch->fd = -1;
+}
+
+/* Arena bitmap: first fit of n contiguous blocks
+ * Complexity: O(B/64) words scanned, full words skipped
+ */
+static long mimix_ipc_bitmap_alloc(mimix_ipc_shared_t *shm, unsigned long n) {
+	unsigned long *bits = (unsigned long *) ((unsigned char *) shm
+			+ shm->bitmap_offset);
+	unsigned long run = 0;
+	unsigned long i;
+
+	for (i = 0; i < shm->arena_blocks; i++) {
+		if ((i % MIMIX_IPC_BITS) == 0 && run == 0
+				&& bits[i / MIMIX_IPC_BITS] == ~0UL) {
+			i += MIMIX_IPC_BITS - 1;
+			continue;
+		}
+		if (bits[i / MIMIX_IPC_BITS] & (1UL << (i % MIMIX_IPC_BITS))) {
+			run = 0;
+			continue;
+		}
+		if (++run == n) {
+			unsigned long first = i + 1 - n;
+			unsigned long j;
+
+			for (j = first; j <= i; j++) {
+				bits[j / MIMIX_IPC_BITS] |= 1UL << (j % MIMIX_IPC_BITS);
+			}
+			return (long) first;
+		}
+	}
+	return -1;
+}
+
+static void mimix_ipc_bitmap_free(mimix_ipc_shared_t *shm,
+		unsigned long first, unsigned long n) {
+	unsigned long *bits = (unsigned long *) ((unsigned char *) shm
+			+ shm->bitmap_offset);
+	unsigned long j;
+
+	for (j = first; j < first + n; j++) {
+		bits[j / MIMIX_IPC_BITS] &= ~(1UL << (j % MIMIX_IPC_BITS));
+	}
+}
+
+/* Return a grant's blocks and invalidate every outstanding handle
+ * Complexity: O(n) blocks; caller holds the lock
+ */
+static void mimix_ipc_grant_free(mimix_ipc_shared_t *shm,
+		mimix_ipc_grant_entry_t *g) {
+	mimix_ipc_bitmap_free(shm, g->offset / MIMIX_IPC_BLOCK_SIZE, g->nblocks);
+	g->generation++;
+	g->state = MIMIX_IPC_GRANT_FREE;
+	g->mapped = 0;
+}
+
+/* Decode a handle into its table entry
+ * Complexity: O(1)
+ */
+static mimix_ipc_grant_entry_t *mimix_ipc_lookup(mimix_ipc_channel_t *ch,
+		mimix_ipc_cap_t cap) {
+	unsigned long index = (cap & 0xFFFFFFFFUL);
+
+	if (index == 0 || index > MIMIX_IPC_MAX_GRANTS) {
+		return NULL;
+	}
+	return &ch->shm->grants[index - 1];
+}
+
+int mimix_ipc_grant(mimix_ipc_channel_t *ch, size_t length,
+		unsigned int rights, mimix_ipc_cap_t *cap, void **buf) {
+	mimix_ipc_shared_t *shm = ch->shm;
+	unsigned long nblocks = (length + MIMIX_IPC_BLOCK_SIZE - 1)
+			/ MIMIX_IPC_BLOCK_SIZE;
+	mimix_ipc_grant_entry_t *g = NULL;
+	unsigned int i, slot = 0;
+	long first;
+
+	if (length == 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	mimix_ipc_lock(&shm->lock);
+	for (i = 0; i < MIMIX_IPC_MAX_GRANTS; i++) {
+		slot = (shm->grant_hint + i) % MIMIX_IPC_MAX_GRANTS;
+		if (shm->grants[slot].state == MIMIX_IPC_GRANT_FREE) {
+			g = &shm->grants[slot];
+			break;
+		}
+	}
+	first = (g != NULL) ? mimix_ipc_bitmap_alloc(shm, nblocks) : -1;
+	if (first < 0) {
+		mimix_ipc_unlock(&shm->lock);
+		errno = ENOMEM;
+		return -1;
+	}
+
+	g->state = MIMIX_IPC_GRANT_LIVE;
+	g->owner = (unsigned int) ch->side;
+	g->rights = rights;
+	g->mapped = 0;
+	g->offset = (unsigned long) first * MIMIX_IPC_BLOCK_SIZE;
+	g->length = length;
+	g->nblocks = nblocks;
+	shm->grant_hint = (slot + 1) % MIMIX_IPC_MAX_GRANTS;
+
+	*cap = ((unsigned long) g->generation << 32) | (slot + 1UL);
+	*buf = ch->arena + g->offset;
+	mimix_ipc_unlock(&shm->lock);
+	return 0;
+}
+
+void *mimix_ipc_map(mimix_ipc_channel_t *ch, const mimix_ipc_desc_t *desc,
+		unsigned int rights) {
+	mimix_ipc_grant_entry_t *g = mimix_ipc_lookup(ch, desc->cap);
+	void *ptr = NULL;
+
+	if (g == NULL) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	mimix_ipc_lock(&ch->shm->lock);
+	if (g->state != MIMIX_IPC_GRANT_LIVE
+			|| g->generation != MIMIX_IPC_CAP_GEN(desc->cap)) {
+		errno = ESTALE;
+	} else if (g->owner != (unsigned int) ch->side
+			&& (rights & ~g->rights) != 0) {
+		errno = EACCES;
+	} else if (desc->offset > g->length
+			|| desc->length > g->length - desc->offset) {
+		errno = EINVAL;
+	} else {
+		if (g->owner != (unsigned int) ch->side) {
+			g->mapped = 1;
+		}
+		ptr = ch->arena + g->offset + desc->offset;
+	}
+	mimix_ipc_unlock(&ch->shm->lock);
+
+	return ptr;
+}
+
+int mimix_ipc_release(mimix_ipc_channel_t *ch, mimix_ipc_cap_t cap) {
+	mimix_ipc_grant_entry_t *g = mimix_ipc_lookup(ch, cap);
+	unsigned int gen = MIMIX_IPC_CAP_GEN(cap);
+	int result = 0;
+
+	if (g == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	mimix_ipc_lock(&ch->shm->lock);
+	if ((g->state == MIMIX_IPC_GRANT_LIVE && g->generation == gen)
+			|| (g->state == MIMIX_IPC_GRANT_QUARANTINE
+					&& g->generation == gen + 1)) {
+		mimix_ipc_grant_free(ch->shm, g);
+	} else {
+		errno = ESTALE;
+		result = -1;
+	}
+	mimix_ipc_unlock(&ch->shm->lock);
+
+	return result;
+}
+
+int mimix_ipc_revoke(mimix_ipc_channel_t *ch, mimix_ipc_cap_t cap) {
+	mimix_ipc_grant_entry_t *g = mimix_ipc_lookup(ch, cap);
+	int result = 0;
+
+	if (g == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	mimix_ipc_lock(&ch->shm->lock);
+	if (g->state != MIMIX_IPC_GRANT_LIVE
+			|| g->generation != MIMIX_IPC_CAP_GEN(cap)) {
+		errno = ESTALE;
+		result = -1;
+	} else if (g->owner != (unsigned int) ch->side) {
+		errno = EPERM;
+		result = -1;
+	} else if (g->mapped) {
+		/* Peer holds a pointer: block reuse until it releases */
+		g->generation++;
+		g->state = MIMIX_IPC_GRANT_QUARANTINE;
+	} else {
+		mimix_ipc_grant_free(ch->shm, g);
+	}
+	mimix_ipc_unlock(&ch->shm->lock);
+
+	return result;
+}
+
+int mimix_ipc_send(mimix_ipc_channel_t *ch, const mimix_ipc_desc_t *desc) {
+	mimix_ipc_ring_t *ring = &ch->shm->ring[ch->side];
+	unsigned int head = ring->head;
+	unsigned int tail;
+	_TRACE_SCOPE("ipc_send");
+
+	for (;;) {
+		tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+		if (head - tail < MIMIX_IPC_RING_SLOTS) {
+			break;
+		}
+		if (mimix_ipc_spin_until_changed(&ring->tail, tail)) {
+			continue;
+		}
+		__atomic_store_n(&ring->tail_waiters, 1, __ATOMIC_SEQ_CST);
+		tail = __atomic_load_n(&ring->tail, __ATOMIC_SEQ_CST);
+		if (head - tail >= MIMIX_IPC_RING_SLOTS) {
+			mimix_ipc_futex_wait(&ring->tail, tail, NULL);
+		}
+		__atomic_store_n(&ring->tail_waiters, 0, __ATOMIC_RELAXED);
+	}
+
+	ring->slots[head & MIMIX_IPC_RING_MASK] = *desc;
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&ring->head_waiters, __ATOMIC_RELAXED)) {
+		mimix_ipc_futex_wake(&ring->head);
+	}
+	return 0;
+}
+
+int mimix_ipc_recv(mimix_ipc_channel_t *ch, mimix_ipc_desc_t *desc,
+		int block) {
+	return mimix_ipc_recv_timed(ch, desc, block ? -1L : 0L);
+}
+
+/* Monotonic clock in nanoseconds, for recv deadlines */
+static unsigned long mimix_ipc_now_ns(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long) ts.tv_sec * 1000000000UL
+			+ (unsigned long) ts.tv_nsec;
+}
+
+/* Deadline is fixed on entry, so spurious or stale wakeups never extend
+ * the wait; each futex sleep gets only the time that is left
+ */
+int mimix_ipc_recv_timed(mimix_ipc_channel_t *ch, mimix_ipc_desc_t *desc,
+		long timeout_ms) {
+	mimix_ipc_ring_t *ring = &ch->shm->ring[1 - ch->side];
+	unsigned int tail = ring->tail;
+	unsigned int head;
+	unsigned long deadline = 0, now;
+	struct timespec left;
+	_TRACE_SCOPE("ipc_recv");
+
+	if (timeout_ms > 0) {
+		deadline = mimix_ipc_now_ns()
+				+ (unsigned long) timeout_ms * 1000000UL;
+	}
+	for (;;) {
+		head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+		if (head != tail) {
+			break;
+		}
+		if (timeout_ms == 0) {
+			errno = EAGAIN;
+			return -1;
+		}
+		if (mimix_ipc_spin_until_changed(&ring->head, head)) {
+			continue;
+		}
+		if (timeout_ms > 0) {
+			now = mimix_ipc_now_ns();
+			if (now >= deadline) {
+				errno = ETIMEDOUT;
+				return -1;
+			}
+			left.tv_sec = (time_t) ((deadline - now) / 1000000000UL);
+			left.tv_nsec = (long) ((deadline - now) % 1000000000UL);
+		}
+		__atomic_store_n(&ring->head_waiters, 1, __ATOMIC_SEQ_CST);
+		head = __atomic_load_n(&ring->head, __ATOMIC_SEQ_CST);
+		if (head == tail) {
+			mimix_ipc_futex_wait(&ring->head, head,
+					(timeout_ms > 0) ? &left : NULL);
+		}
+		__atomic_store_n(&ring->head_waiters, 0, __ATOMIC_RELAXED);
+	}
+
+	*desc = ring->slots[tail & MIMIX_IPC_RING_MASK];
+	__atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&ring->tail_waiters, __ATOMIC_RELAXED)) {
+		mimix_ipc_futex_wake(&ring->tail);
+	}
+	return 0;
+}
@@ -0,0 +1,427 @@
+/* Radix Page Tables for MIMIX 3.1.2
+ *
+ * Functional Paradigm: Recursive range operations over a 512-ary radix
+ * Big O Complexity: O(4) walk, O(n / leaf size) map, unmap and protect
+ * Memory Optimization: Empty tables return to the pool on unmap
+ * Architecture: Pool-relative table addresses, x86-64 entry layout
+ */
+
+#include <headers/paging.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define MIMIX_PT_SHIFT(level)  (MIMIX_PAGE_SHIFT + MIMIX_PT_INDEX_BITS * (level))
+#define MIMIX_PT_INDEX(va, level) \
+	(((va) >> MIMIX_PT_SHIFT(level)) & (MIMIX_PT_ENTRIES - 1))
+#define MIMIX_PT_TABLE(pool, addr) \
+	((unsigned long *) ((pool)->base + ((addr) & MIMIX_PTE_ADDR)))
+
+/* Interior entries are permissive; the leaf decides access */
+#define MIMIX_PT_TABLE_FLAGS   (MIMIX_PTE_PRESENT | MIMIX_PTE_WRITE \
+                                | MIMIX_PTE_USER)
+
+#define MIMIX_PT_OP_UNMAP      0
+#define MIMIX_PT_OP_PROTECT    1
+
+int mimix_page_pool_init(mimix_page_pool_t *pool, unsigned long npages) {
+	unsigned long i;
+	void *base;
+
+	memset(pool, 0, sizeof(*pool));
+	if (npages == 0 || npages > (MIMIX_PTE_ADDR >> MIMIX_PAGE_SHIFT)) {
+		errno = EINVAL;
+		return -1;
+	}
+	base = mmap(NULL, npages * MIMIX_PAGE_SIZE, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (base == MAP_FAILED) {
+		return -1;
+	}
+	pool->free_stack = (unsigned int *) malloc(npages * sizeof(unsigned int));
+	if (pool->free_stack == NULL) {
+		munmap(base, npages * MIMIX_PAGE_SIZE);
+		errno = ENOMEM;
+		return -1;
+	}
+	/* Low pages pop first, keeping tables dense at the start of the pool */
+	for (i = 0; i < npages; i++) {
+		pool->free_stack[i] = (unsigned int) (npages - 1 - i);
+	}
+	pool->base = (unsigned char *) base;
+	pool->npages = npages;
+	pool->nfree = npages;
+	return 0;
+}
+
+int mimix_page_pool_restore(mimix_page_pool_t *pool, int fd,
+		unsigned long offset, unsigned long npages,
+		const unsigned int *free_stack, unsigned long nfree) {
+	unsigned long i;
+	void *base;
+
+	memset(pool, 0, sizeof(*pool));
+	if (npages == 0 || npages > (MIMIX_PTE_ADDR >> MIMIX_PAGE_SHIFT)
+			|| nfree > npages || (offset & (MIMIX_PAGE_SIZE - 1)) != 0) {
+		errno = EINVAL;
+		return -1;
+	}
+	for (i = 0; i < nfree; i++) {
+		if (free_stack[i] >= npages) {
+			errno = EINVAL;
+			return -1;
+		}
+	}
+	/* Private mapping: pages fault in from the page cache on first touch */
+	base = mmap(NULL, npages * MIMIX_PAGE_SIZE, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE, fd, (off_t) offset);
+	if (base == MAP_FAILED) {
+		return -1;
+	}
+	pool->free_stack = (unsigned int *) malloc(npages * sizeof(unsigned int));
+	if (pool->free_stack == NULL) {
+		munmap(base, npages * MIMIX_PAGE_SIZE);
+		errno = ENOMEM;
+		return -1;
+	}
+	memcpy(pool->free_stack, free_stack, nfree * sizeof(unsigned int));
+	pool->base = (unsigned char *) base;
+	pool->npages = npages;
+	pool->nfree = nfree;
+	return 0;
+}
+
+void mimix_page_pool_destroy(mimix_page_pool_t *pool) {
+	if (pool->base != NULL) {
+		munmap(pool->base, pool->npages * MIMIX_PAGE_SIZE);
+	}
+	free(pool->free_stack);
+	memset(pool, 0, sizeof(*pool));
+}
+
+/* Pop a zeroed table page
+ * Complexity: O(1) plus the 4 KiB clear
+ */
+static int mimix_pt_page_alloc(mimix_pt_space_t *space, unsigned long *addr) {
+	mimix_page_pool_t *pool = space->pool;
+
+	if (pool->nfree == 0) {
+		errno = ENOMEM;
+		return -1;
+	}
+	*addr = (unsigned long) pool->free_stack[--pool->nfree] << MIMIX_PAGE_SHIFT;
+	memset(pool->base + *addr, 0, MIMIX_PAGE_SIZE);
+	space->tables++;
+	return 0;
+}
+
+static void mimix_pt_page_free(mimix_pt_space_t *space, unsigned long addr) {
+	space->pool->free_stack[space->pool->nfree++] =
+			(unsigned int) (addr >> MIMIX_PAGE_SHIFT);
+	space->tables--;
+}
+
+/* Queue one leaf for invalidation; too many turns into an ASID flush
+ * Complexity: O(1)
+ */
+static void mimix_pt_queue(mimix_tlb_batch_t *batch, unsigned long va,
+		unsigned int shift) {
+	if (batch == NULL || batch->overflow) {
+		return;
+	}
+	if (batch->count == MIMIX_TLB_BATCH) {
+		batch->overflow = 1;
+		return;
+	}
+	batch->va[batch->count] = va;
+	batch->shift[batch->count] = shift;
+	batch->count++;
+}
+
+static int mimix_pt_table_empty(const unsigned long *table) {
+	int i;
+
+	for (i = 0; i < MIMIX_PT_ENTRIES; i++) {
+		if (table[i] != 0) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+int mimix_pt_init(mimix_pt_space_t *space, mimix_page_pool_t *pool,
+		unsigned int asid) {
+	memset(space, 0, sizeof(*space));
+	space->pool = pool;
+	space->asid = asid;
+	return mimix_pt_page_alloc(space, &space->root);
+}
+
+/* Return a table and everything below it to the pool
+ * Complexity: O(t) - t tables in the subtree
+ */
+static void mimix_pt_free_tree(mimix_pt_space_t *space, unsigned long addr,
+		int level) {
+	unsigned long *table = MIMIX_PT_TABLE(space->pool, addr);
+	int i;
+
+	for (i = 0; level > 0 && i < MIMIX_PT_ENTRIES; i++) {
+		if ((table[i] & MIMIX_PTE_PRESENT) && !(table[i] & MIMIX_PTE_HUGE)) {
+			mimix_pt_free_tree(space, table[i] & MIMIX_PTE_ADDR, level - 1);
+		}
+	}
+	mimix_pt_page_free(space, addr);
+}
+
+void mimix_pt_destroy(mimix_pt_space_t *space) {
+	if (space->pool != NULL) {
+		mimix_pt_free_tree(space, space->root, MIMIX_PT_LEVELS - 1);
+	}
+	memset(space, 0, sizeof(*space));
+}
+
+/* Find the entry for va at a leaf level, creating interior tables
+ * Complexity: O(4)
+ */
+static unsigned long *mimix_pt_slot(mimix_pt_space_t *space, unsigned long va,
+		int leaf_level) {
+	unsigned long *table = MIMIX_PT_TABLE(space->pool, space->root);
+	int level;
+
+	for (level = MIMIX_PT_LEVELS - 1; level > leaf_level; level--) {
+		unsigned long *pte = &table[MIMIX_PT_INDEX(va, level)];
+
+		if (!(*pte & MIMIX_PTE_PRESENT)) {
+			unsigned long addr;
+
+			if (mimix_pt_page_alloc(space, &addr) != 0) {
+				return NULL;
+			}
+			*pte = addr | MIMIX_PT_TABLE_FLAGS;
+		} else if (*pte & MIMIX_PTE_HUGE) {
+			errno = EEXIST;
+			return NULL;
+		}
+		table = MIMIX_PT_TABLE(space->pool, *pte);
+	}
+	return &table[MIMIX_PT_INDEX(va, leaf_level)];
+}
+
+/* Install the largest leaf that fits at va, reporting its size
+ * Complexity: O(4)
+ */
+static int mimix_pt_map_one(mimix_pt_space_t *space, unsigned long va,
+		unsigned long pa, unsigned long remaining, unsigned long flags,
+		unsigned long *size) {
+	int level = (flags & MIMIX_PT_ALLOW_HUGE) ? MIMIX_PT_HUGE_LEVELS - 1 : 0;
+	unsigned long *slot;
+
+	for (;;) {
+		*size = 1UL << MIMIX_PT_SHIFT(level);
+		if (level > 0 && (((va | pa) & (*size - 1)) != 0
+				|| remaining < *size)) {
+			level--;
+			continue;
+		}
+		slot = mimix_pt_slot(space, va, level);
+		if (slot == NULL) {
+			return -1;
+		}
+		/* A table already sits here: fill it with smaller leaves */
+		if (level > 0 && (*slot & MIMIX_PTE_PRESENT)
+				&& !(*slot & MIMIX_PTE_HUGE)) {
+			level--;
+			continue;
+		}
+		break;
+	}
+	if (*slot & MIMIX_PTE_PRESENT) {
+		errno = EEXIST;
+		return -1;
+	}
+	*slot = pa | MIMIX_PTE_PRESENT | (flags & MIMIX_PTE_PERMS)
+			| (level > 0 ? MIMIX_PTE_HUGE : 0);
+	return 0;
+}
+
+/* Range arguments: page aligned, non-empty, inside the 48-bit space */
+static int mimix_pt_check_range(unsigned long va, unsigned long len) {
+	if (len == 0 || ((va | len) & (MIMIX_PAGE_SIZE - 1)) != 0
+			|| va + len < va || ((va + len - 1) >> MIMIX_PT_VA_BITS) != 0) {
+		errno = EINVAL;
+		return -1;
+	}
+	return 0;
+}
+
+/* Free the empty interior tables along va's path, bottom up; a failed
+ * map leaves the tables it allocated before running out linked there
+ * Complexity: O(4) plus an O(512) emptiness scan per table
+ */
+static void mimix_pt_prune(mimix_pt_space_t *space, unsigned long table_addr,
+		int level, unsigned long va) {
+	unsigned long *table = MIMIX_PT_TABLE(space->pool, table_addr);
+	unsigned long *pte = &table[MIMIX_PT_INDEX(va, level)];
+
+	if (level == 0 || !(*pte & MIMIX_PTE_PRESENT) || (*pte & MIMIX_PTE_HUGE)) {
+		return;
+	}
+	mimix_pt_prune(space, *pte & MIMIX_PTE_ADDR, level - 1, va);
+	if (mimix_pt_table_empty(MIMIX_PT_TABLE(space->pool, *pte))) {
+		mimix_pt_page_free(space, *pte & MIMIX_PTE_ADDR);
+		*pte = 0;
+	}
+}
+
+int mimix_pt_map(mimix_pt_space_t *space, unsigned long va, unsigned long pa,
+		unsigned long len, unsigned long flags) {
+	unsigned long done = 0;
+	unsigned long size;
+
+	if (mimix_pt_check_range(va, len) != 0
+			|| (pa & (MIMIX_PAGE_SIZE - 1)) != 0
+			|| ((pa + len - 1) & ~(MIMIX_PTE_ADDR | (MIMIX_PAGE_SIZE - 1)))
+					!= 0) {
+		errno = EINVAL;
+		return -1;
+	}
+	while (done < len) {
+		if (mimix_pt_map_one(space, va + done, pa + done, len - done, flags,
+				&size) != 0) {
+			int saved = errno;
+
+			/* Not yet visible to any TLB, so no shootdown is needed.
+			 * Prune first: unmap then sees the shared parents empty
+			 */
+			mimix_pt_prune(space, space->root, MIMIX_PT_LEVELS - 1, va + done);
+			if (done > 0) {
+				mimix_pt_unmap(space, va, done, NULL);
+			}
+			errno = saved;
+			return -1;
+		}
+		done += size;
+	}
+	return 0;
+}
+
+/* Replace a huge leaf with a table of next-level leaves covering it
+ * Complexity: O(512)
+ */
+static int mimix_pt_split(mimix_pt_space_t *space, unsigned long *pte,
+		int level, unsigned long va, mimix_tlb_batch_t *batch) {
+	unsigned long sub = 1UL << MIMIX_PT_SHIFT(level - 1);
+	unsigned long leaf = *pte;
+	unsigned long bits = leaf & ~MIMIX_PTE_ADDR;
+	unsigned long *child;
+	unsigned long addr;
+	int i;
+
+	if (mimix_pt_page_alloc(space, &addr) != 0) {
+		return -1;
+	}
+	if (level - 1 == 0) {
+		bits &= ~MIMIX_PTE_HUGE;
+	}
+	child = MIMIX_PT_TABLE(space->pool, addr);
+	for (i = 0; i < MIMIX_PT_ENTRIES; i++) {
+		child[i] = ((leaf & MIMIX_PTE_ADDR) + (unsigned long) i * sub) | bits;
+	}
+	*pte = addr | MIMIX_PT_TABLE_FLAGS;
+	mimix_pt_queue(batch, va, MIMIX_PT_SHIFT(level));
+	return 0;
+}
+
+/* Apply unmap or protect to [start, end) below one table
+ * Complexity: O(n / leaf size) plus an O(512) emptiness scan per table
+ */
+static int mimix_pt_range(mimix_pt_space_t *space, unsigned long table_addr,
+		int level, unsigned long start, unsigned long end, int op,
+		unsigned long flags, mimix_tlb_batch_t *batch) {
+	unsigned long *table = MIMIX_PT_TABLE(space->pool, table_addr);
+	unsigned long size = 1UL << MIMIX_PT_SHIFT(level);
+	unsigned long va = start;
+
+	while (va < end) {
+		unsigned long *pte = &table[MIMIX_PT_INDEX(va, level)];
+		unsigned long base = va & ~(size - 1);
+		unsigned long hi = (base + size < end) ? base + size : end;
+
+		if (!(*pte & MIMIX_PTE_PRESENT)) {
+			if (op == MIMIX_PT_OP_PROTECT) {
+				errno = ENOMEM;  /* As mprotect(2) on a hole */
+				return -1;
+			}
+		} else if ((level == 0 || (*pte & MIMIX_PTE_HUGE))
+				&& va == base && hi == base + size) {
+			mimix_pt_queue(batch, base, MIMIX_PT_SHIFT(level));
+			if (op == MIMIX_PT_OP_UNMAP) {
+				*pte = 0;
+			} else {
+				*pte = (*pte & ~MIMIX_PTE_PERMS) | (flags & MIMIX_PTE_PERMS);
+			}
+		} else {
+			if ((*pte & MIMIX_PTE_HUGE)
+					&& mimix_pt_split(space, pte, level, base, batch) != 0) {
+				return -1;
+			}
+			if (mimix_pt_range(space, *pte & MIMIX_PTE_ADDR, level - 1, va, hi,
+					op, flags, batch) != 0) {
+				return -1;
+			}
+			if (op == MIMIX_PT_OP_UNMAP && mimix_pt_table_empty(
+					MIMIX_PT_TABLE(space->pool, *pte))) {
+				mimix_pt_page_free(space, *pte & MIMIX_PTE_ADDR);
+				*pte = 0;
+			}
+		}
+		va = hi;
+	}
+	return 0;
+}
+
+int mimix_pt_unmap(mimix_pt_space_t *space, unsigned long va,
+		unsigned long len, mimix_tlb_batch_t *batch) {
+	if (mimix_pt_check_range(va, len) != 0) {
+		return -1;
+	}
+	return mimix_pt_range(space, space->root, MIMIX_PT_LEVELS - 1, va, va + len,
+			MIMIX_PT_OP_UNMAP, 0, batch);
+}
+
+int mimix_pt_protect(mimix_pt_space_t *space, unsigned long va,
+		unsigned long len, unsigned long flags, mimix_tlb_batch_t *batch) {
+	if (mimix_pt_check_range(va, len) != 0) {
+		return -1;
+	}
+	return mimix_pt_range(space, space->root, MIMIX_PT_LEVELS - 1, va, va + len,
+			MIMIX_PT_OP_PROTECT, flags, batch);
+}
+
+int mimix_pt_walk(mimix_pt_space_t *space, unsigned long va,
+		unsigned long *pte, unsigned int *shift) {
+	unsigned long *table = MIMIX_PT_TABLE(space->pool, space->root);
+	int level;
+
+	space->walks++;
+	if ((va >> MIMIX_PT_VA_BITS) != 0) {
+		errno = EFAULT;
+		return -1;
+	}
+	for (level = MIMIX_PT_LEVELS - 1; level >= 0; level--) {
+		unsigned long entry = table[MIMIX_PT_INDEX(va, level)];
+
+		if (!(entry & MIMIX_PTE_PRESENT)) {
+			break;
+		}
+		if (level == 0 || (entry & MIMIX_PTE_HUGE)) {
+			*pte = entry;
+			*shift = MIMIX_PT_SHIFT(level);
+			return 0;
+		}
+		table = MIMIX_PT_TABLE(space->pool, entry);
+	}
+	errno = EFAULT;
+	return -1;
+}
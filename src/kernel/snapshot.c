@@ -0,0 +1,384 @@
+/* Kernel-State Snapshot Image for MIMIX 3.1.2
+ *
+ * Functional Paradigm: Append sections, seal the header, rename into place
+ * Big O Complexity: O(n) write, O(1) open, O(n) lazy section checksums
+ * Memory Optimization: Read-only image mapping, pool pages mapped in place
+ * Architecture: Header page + page-aligned sections, 4-lane checksum
+ */
+
+#include <headers/snapshot.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define MIMIX_SNAP_PRIME       0x9E3779B97F4A7C15UL
+#define MIMIX_SNAP_LANES       4
+#define MIMIX_SNAP_ROUND(n)    (((n) + MIMIX_SNAP_ALIGN - 1) \
+                                & ~(unsigned long) (MIMIX_SNAP_ALIGN - 1))
+
+/* Damage detector: four independent multiply chains, folded at the end
+ * Complexity: O(n), about one word per cycle
+ */
+static unsigned long mimix_snap_checksum(const unsigned char *p,
+		unsigned long len) {
+	unsigned long h[MIMIX_SNAP_LANES];
+	unsigned long i, w, sum = len;
+	int k;
+
+	for (k = 0; k < MIMIX_SNAP_LANES; k++) {
+		h[k] = MIMIX_SNAP_PRIME * (unsigned long) (k + 1);
+	}
+	for (i = 0; i + MIMIX_SNAP_LANES * sizeof(w) <= len;
+			i += MIMIX_SNAP_LANES * sizeof(w)) {
+		for (k = 0; k < MIMIX_SNAP_LANES; k++) {
+			memcpy(&w, p + i + k * sizeof(w), sizeof(w));
+			h[k] = (h[k] ^ w) * MIMIX_SNAP_PRIME;
+			h[k] ^= h[k] >> 29;
+		}
+	}
+	for (; i < len; i++) {
+		h[0] = (h[0] ^ p[i]) * MIMIX_SNAP_PRIME;
+	}
+	for (k = 0; k < MIMIX_SNAP_LANES; k++) {
+		sum = (sum ^ h[k]) * MIMIX_SNAP_PRIME;
+		sum ^= sum >> 32;
+	}
+	return sum;
+}
+
+static unsigned long mimix_snap_header_checksum(const mimix_snap_header_t *h) {
+	mimix_snap_header_t copy = *h;
+
+	copy.checksum = 0;
+	return mimix_snap_checksum((const unsigned char *) &copy, sizeof(copy));
+}
+
+/* Everything that decides how this build reads an image: record sizes,
+ * PTE bits and table geometry; any change makes older images stale
+ * Complexity: O(1)
+ */
+static unsigned long mimix_snap_layout(void) {
+	unsigned long facts[18];
+
+	facts[0] = sizeof(mimix_snap_header_t);
+	facts[1] = sizeof(mimix_snap_section_t);
+	facts[2] = sizeof(mimix_snap_space_t);
+	facts[3] = sizeof(unsigned int);  /* Free stack entry */
+	facts[4] = MIMIX_PAGE_SIZE;
+	facts[5] = MIMIX_PT_LEVELS;
+	facts[6] = MIMIX_PT_ENTRIES;
+	facts[7] = MIMIX_PT_INDEX_BITS;
+	facts[8] = MIMIX_PT_VA_BITS;
+	facts[9] = MIMIX_PT_HUGE_LEVELS;
+	facts[10] = MIMIX_PTE_PRESENT;
+	facts[11] = MIMIX_PTE_WRITE;
+	facts[12] = MIMIX_PTE_USER;
+	facts[13] = MIMIX_PTE_HUGE;
+	facts[14] = MIMIX_PTE_GLOBAL;
+	facts[15] = MIMIX_PTE_NX;
+	facts[16] = MIMIX_PTE_ADDR;
+	facts[17] = MIMIX_PTE_PERMS;
+	return mimix_snap_checksum((const unsigned char *) facts, sizeof(facts));
+}
+
+static int mimix_snap_pwrite_all(int fd, const void *data, unsigned long len,
+		unsigned long offset) {
+	const unsigned char *p = (const unsigned char *) data;
+
+	while (len > 0) {
+		ssize_t n = pwrite(fd, p, len, (off_t) offset);
+
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -1;
+		}
+		p += n;
+		offset += (unsigned long) n;
+		len -= (unsigned long) n;
+	}
+	return 0;
+}
+
+int mimix_snap_create(mimix_snap_writer_t *w, const char *path,
+		unsigned long build) {
+	memset(w, 0, sizeof(*w));
+	w->fd = -1;
+	if (strlen(path) >= MIMIX_SNAP_PATH_MAX) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	strcpy(w->path, path);
+	sprintf(w->tmp, "%s.tmp", path);
+	w->fd = open(w->tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (w->fd < 0) {
+		return -1;
+	}
+	w->header.magic = MIMIX_SNAP_MAGIC;
+	w->header.build = build;
+	w->header.layout = mimix_snap_layout();
+	w->header.version = MIMIX_SNAP_VERSION;
+	w->header.page_size = (unsigned int) MIMIX_PAGE_SIZE;
+	w->offset = MIMIX_SNAP_ROUND(sizeof(mimix_snap_header_t));
+	return 0;
+}
+
+int mimix_snap_write(mimix_snap_writer_t *w, unsigned int id,
+		const void *data, unsigned long len) {
+	mimix_snap_section_t *s;
+
+	if (w->header.nsections == MIMIX_SNAP_MAX_SECTIONS) {
+		errno = ENOSPC;
+		return -1;
+	}
+	if (mimix_snap_pwrite_all(w->fd, data, len, w->offset) != 0) {
+		return -1;
+	}
+	s = &w->header.sections[w->header.nsections++];
+	s->id = id;
+	s->offset = w->offset;
+	s->length = len;
+	s->checksum = mimix_snap_checksum((const unsigned char *) data, len);
+	w->offset += MIMIX_SNAP_ROUND(len);
+	return 0;
+}
+
+int mimix_snap_commit(mimix_snap_writer_t *w) {
+	int saved;
+
+	/* Pad the last section so every section maps whole pages */
+	w->header.size = w->offset;
+	w->header.checksum = mimix_snap_header_checksum(&w->header);
+	if (ftruncate(w->fd, (off_t) w->offset) != 0
+			|| mimix_snap_pwrite_all(w->fd, &w->header, sizeof(w->header), 0)
+					!= 0
+			|| fsync(w->fd) != 0) {
+		saved = errno;
+		mimix_snap_abort(w);
+		errno = saved;
+		return -1;
+	}
+	close(w->fd);
+	w->fd = -1;
+	if (rename(w->tmp, w->path) != 0) {
+		saved = errno;
+		unlink(w->tmp);
+		errno = saved;
+		return -1;
+	}
+	return 0;
+}
+
+void mimix_snap_abort(mimix_snap_writer_t *w) {
+	if (w->fd >= 0) {
+		close(w->fd);
+		unlink(w->tmp);
+	}
+	w->fd = -1;
+}
+
+/* Header checks in order: damaged, then stale, then section bounds.
+ * The version goes before the checksum: another format may have another
+ * header size, which would read as damage.
+ * Complexity: O(sections)
+ */
+static int mimix_snap_validate(const mimix_snap_header_t *h,
+		unsigned long size, unsigned long build) {
+	unsigned int i;
+
+	if (h->magic != MIMIX_SNAP_MAGIC) {
+		errno = EBADMSG;
+		return -1;
+	}
+	if (h->version != MIMIX_SNAP_VERSION) {
+		errno = ESTALE;
+		return -1;
+	}
+	if (h->checksum != mimix_snap_header_checksum(h)) {
+		errno = EBADMSG;
+		return -1;
+	}
+	if (h->build != build || h->layout != mimix_snap_layout()
+			|| h->page_size != MIMIX_PAGE_SIZE) {
+		errno = ESTALE;
+		return -1;
+	}
+	if (h->size != size || h->nsections > MIMIX_SNAP_MAX_SECTIONS) {
+		errno = EBADMSG;
+		return -1;
+	}
+	for (i = 0; i < h->nsections; i++) {
+		const mimix_snap_section_t *s = &h->sections[i];
+
+		if ((s->offset & (MIMIX_SNAP_ALIGN - 1)) != 0
+				|| s->offset < MIMIX_SNAP_ALIGN || s->offset > size
+				|| s->length > size - s->offset) {
+			errno = EBADMSG;
+			return -1;
+		}
+	}
+	return 0;
+}
+
+int mimix_snap_open(mimix_snap_t *snap, const char *path,
+		unsigned long build) {
+	struct stat st;
+	void *base = MAP_FAILED;
+	int fd, saved;
+
+	memset(snap, 0, sizeof(*snap));
+	snap->fd = -1;
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return -1;
+	}
+	if (fstat(fd, &st) == 0) {
+		if ((unsigned long) st.st_size < sizeof(mimix_snap_header_t)) {
+			errno = EBADMSG;
+		} else {
+			base = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE,
+					fd, 0);
+		}
+	}
+	if (base == MAP_FAILED) {
+		saved = errno;
+		close(fd);
+		errno = saved;
+		return -1;
+	}
+	snap->fd = fd;
+	snap->base = (unsigned char *) base;
+	snap->size = (unsigned long) st.st_size;
+	snap->header = (const mimix_snap_header_t *) base;
+	if (mimix_snap_validate(snap->header, snap->size, build) != 0) {
+		saved = errno;
+		mimix_snap_close(snap);
+		errno = saved;
+		return -1;
+	}
+	return 0;
+}
+
+const void *mimix_snap_section(mimix_snap_t *snap, unsigned int id,
+		unsigned long *len) {
+	unsigned int i;
+
+	for (i = 0; i < snap->header->nsections; i++) {
+		const mimix_snap_section_t *s = &snap->header->sections[i];
+
+		if (s->id != id) {
+			continue;
+		}
+		if (!(snap->verified & (1U << i))) {
+			if (mimix_snap_checksum(snap->base + s->offset, s->length)
+					!= s->checksum) {
+				errno = EBADMSG;
+				return NULL;
+			}
+			snap->verified |= 1U << i;
+		}
+		*len = s->length;
+		return snap->base + s->offset;
+	}
+	errno = ENOENT;
+	return NULL;
+}
+
+void mimix_snap_close(mimix_snap_t *snap) {
+	if (snap->base != NULL) {
+		munmap(snap->base, snap->size);
+	}
+	if (snap->fd >= 0) {
+		close(snap->fd);
+	}
+	memset(snap, 0, sizeof(*snap));
+	snap->fd = -1;
+}
+
+int mimix_snap_save_paging(mimix_snap_writer_t *w,
+		const mimix_page_pool_t *pool, const mimix_pt_space_t *spaces,
+		int nspaces) {
+	mimix_snap_space_t *records;
+	int i, status;
+
+	for (i = 0; i < nspaces; i++) {
+		if (spaces[i].pool != pool) {
+			errno = EINVAL;
+			return -1;
+		}
+	}
+	records = (mimix_snap_space_t *) calloc((size_t) nspaces + 1,
+			sizeof(mimix_snap_space_t));
+	if (records == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	for (i = 0; i < nspaces; i++) {
+		records[i].root = spaces[i].root;
+		records[i].tables = spaces[i].tables;
+		records[i].asid = spaces[i].asid;
+	}
+	status = (mimix_snap_write(w, MIMIX_SNAP_POOL_PAGES, pool->base,
+					pool->npages * MIMIX_PAGE_SIZE) != 0
+			|| mimix_snap_write(w, MIMIX_SNAP_POOL_FREE, pool->free_stack,
+					pool->nfree * sizeof(unsigned int)) != 0
+			|| mimix_snap_write(w, MIMIX_SNAP_SPACES, records,
+					(unsigned long) nspaces * sizeof(mimix_snap_space_t))
+					!= 0) ? -1 : 0;
+	free(records);
+	return status;
+}
+
+int mimix_snap_restore_paging(mimix_snap_t *snap, mimix_page_pool_t *pool,
+		mimix_pt_space_t *spaces, int nspaces) {
+	const unsigned char *pages;
+	const unsigned int *free_stack;
+	const mimix_snap_space_t *records;
+	unsigned long plen, flen, slen;
+	int i;
+
+	pages = (const unsigned char *) mimix_snap_section(snap,
+			MIMIX_SNAP_POOL_PAGES, &plen);
+	free_stack = (const unsigned int *) mimix_snap_section(snap,
+			MIMIX_SNAP_POOL_FREE, &flen);
+	records = (const mimix_snap_space_t *) mimix_snap_section(snap,
+			MIMIX_SNAP_SPACES, &slen);
+	if (pages == NULL || free_stack == NULL || records == NULL) {
+		return -1;
+	}
+	/* A space count that differs means the image was built for another boot */
+	if (slen != (unsigned long) nspaces * sizeof(mimix_snap_space_t)) {
+		errno = ESTALE;
+		return -1;
+	}
+	if (plen % MIMIX_PAGE_SIZE != 0 || flen % sizeof(unsigned int) != 0) {
+		errno = EBADMSG;
+		return -1;
+	}
+	for (i = 0; i < nspaces; i++) {
+		if (records[i].root >= plen
+				|| (records[i].root & (MIMIX_PAGE_SIZE - 1)) != 0) {
+			errno = EBADMSG;
+			return -1;
+		}
+	}
+	if (mimix_page_pool_restore(pool, snap->fd,
+			(unsigned long) (pages - snap->base), plen / MIMIX_PAGE_SIZE,
+			free_stack, flen / sizeof(unsigned int)) != 0) {
+		return -1;
+	}
+	for (i = 0; i < nspaces; i++) {
+		memset(&spaces[i], 0, sizeof(spaces[i]));
+		spaces[i].pool = pool;
+		spaces[i].root = records[i].root;
+		spaces[i].tables = records[i].tables;
+		spaces[i].asid = records[i].asid;
+	}
+	return 0;
+}
@@ -0,0 +1,161 @@
+/* Software TLB for MIMIX 3.1.2
+ *
+ * Functional Paradigm: ASID-tagged set-associative cache of leaf entries
+ * Big O Complexity: O(sizes * ways) lookup, O(batch * ways) shootdown
+ * Memory Optimization: One entry covers a whole 4 KiB, 2 MiB or 1 GiB page
+ * Architecture: Round-robin replacement per set, walk on miss
+ *
+ * Each page size has its own set array indexed by the low bits of the
+ * virtual page number, so a huge page occupies one entry rather than
+ * shadowing 512 small ones. Lookups probe the sizes smallest first.
+ */
+
+#include <headers/paging.h>
+#include <errno.h>
+#include <string.h>
+
+static const unsigned int mimix_tlb_shift[MIMIX_PT_HUGE_LEVELS] = {
+	MIMIX_PAGE_SHIFT,
+	MIMIX_PAGE_SHIFT + MIMIX_PT_INDEX_BITS,
+	MIMIX_PAGE_SHIFT + 2 * MIMIX_PT_INDEX_BITS
+};
+
+/* Size class of a leaf shift (12, 21 or 30) */
+#define MIMIX_TLB_CLASS(shift) \
+	((int) (((shift) - MIMIX_PAGE_SHIFT) / MIMIX_PT_INDEX_BITS))
+
+/* Entry usable by asid: its own, or global */
+#define MIMIX_TLB_MATCH(e, v, a) ((e)->pte != 0 && (e)->vpn == (v) \
+	&& ((e)->asid == (a) || ((e)->pte & MIMIX_PTE_GLOBAL)))
+
+void mimix_tlb_init(mimix_tlb_t *tlb) {
+	memset(tlb, 0, sizeof(*tlb));
+}
+
+/* Install a walked leaf, preferring an invalid way
+ * Complexity: O(ways)
+ */
+static void mimix_tlb_fill(mimix_tlb_t *tlb, unsigned int asid,
+		unsigned long va, unsigned long pte, unsigned int shift) {
+	int size = MIMIX_TLB_CLASS(shift);
+	unsigned long vpn = va >> shift;
+	unsigned int set = (unsigned int) (vpn & (MIMIX_TLB_SETS - 1));
+	mimix_tlb_entry_t *ways = tlb->entries[size][set];
+	int w;
+
+	for (w = 0; w < MIMIX_TLB_WAYS && ways[w].pte != 0; w++) {
+		continue;
+	}
+	if (w == MIMIX_TLB_WAYS) {
+		w = tlb->hand[size][set];
+		tlb->hand[size][set] = (unsigned char) ((w + 1) % MIMIX_TLB_WAYS);
+	}
+	ways[w].vpn = vpn;
+	ways[w].pte = pte;
+	ways[w].asid = asid;
+}
+
+int mimix_tlb_translate(mimix_tlb_t *tlb, mimix_pt_space_t *space,
+		unsigned long va, int access, unsigned long *pa) {
+	unsigned long pte = 0;
+	unsigned long mask;
+	unsigned int shift = 0;
+	int size, w;
+
+	for (size = 0; size < MIMIX_PT_HUGE_LEVELS && pte == 0; size++) {
+		unsigned long vpn = va >> mimix_tlb_shift[size];
+		mimix_tlb_entry_t *ways =
+				tlb->entries[size][vpn & (MIMIX_TLB_SETS - 1)];
+
+		for (w = 0; w < MIMIX_TLB_WAYS; w++) {
+			if (MIMIX_TLB_MATCH(&ways[w], vpn, space->asid)) {
+				pte = ways[w].pte;
+				shift = mimix_tlb_shift[size];
+				break;
+			}
+		}
+	}
+
+	if (_LIKELY(pte != 0)) {
+		tlb->stats.hits++;
+	} else {
+		tlb->stats.misses++;
+		if (mimix_pt_walk(space, va, &pte, &shift) != 0) {
+			tlb->stats.faults++;
+			return -1;
+		}
+		mimix_tlb_fill(tlb, space->asid, va, pte, shift);
+	}
+
+	if ((access == MIMIX_TLB_WRITE && !(pte & MIMIX_PTE_WRITE))
+			|| (access == MIMIX_TLB_EXEC && (pte & MIMIX_PTE_NX))) {
+		tlb->stats.faults++;
+		errno = EACCES;
+		return -1;
+	}
+	mask = (1UL << shift) - 1;
+	*pa = ((pte & MIMIX_PTE_ADDR) & ~mask) | (va & mask);
+	return 0;
+}
+
+/* Drops every entry usable by asid, global ones included, since a batch
+ * that overflowed no longer records which pages were global.
+ */
+void mimix_tlb_flush_asid(mimix_tlb_t *tlb, unsigned int asid) {
+	int size, set, w;
+
+	for (size = 0; size < MIMIX_PT_HUGE_LEVELS; size++) {
+		for (set = 0; set < MIMIX_TLB_SETS; set++) {
+			for (w = 0; w < MIMIX_TLB_WAYS; w++) {
+				mimix_tlb_entry_t *e = &tlb->entries[size][set][w];
+
+				if (e->pte != 0 && (e->asid == asid
+						|| (e->pte & MIMIX_PTE_GLOBAL))) {
+					e->pte = 0;
+					tlb->stats.invalidations++;
+				}
+			}
+		}
+	}
+	tlb->stats.flushes++;
+}
+
+void mimix_tlb_batch_init(mimix_tlb_batch_t *batch, unsigned int asid) {
+	batch->asid = asid;
+	batch->count = 0;
+	batch->overflow = 0;
+}
+
+void mimix_tlb_shootdown(mimix_tlb_t *tlbs, int ntlbs,
+		mimix_tlb_batch_t *batch) {
+	unsigned int i;
+	int t, w;
+
+	if (batch->count == 0 && !batch->overflow) {
+		return;
+	}
+	/* One interrupt per TLB per batch, however many pages it covers */
+	for (t = 0; t < ntlbs; t++) {
+		mimix_tlb_t *tlb = &tlbs[t];
+
+		tlb->stats.shootdowns++;
+		if (batch->overflow) {
+			mimix_tlb_flush_asid(tlb, batch->asid);
+			continue;
+		}
+		for (i = 0; i < batch->count; i++) {
+			int size = MIMIX_TLB_CLASS(batch->shift[i]);
+			unsigned long vpn = batch->va[i] >> batch->shift[i];
+			mimix_tlb_entry_t *ways =
+					tlb->entries[size][vpn & (MIMIX_TLB_SETS - 1)];
+
+			for (w = 0; w < MIMIX_TLB_WAYS; w++) {
+				if (MIMIX_TLB_MATCH(&ways[w], vpn, batch->asid)) {
+					ways[w].pte = 0;
+					tlb->stats.invalidations++;
+				}
+			}
+		}
+	}
+	mimix_tlb_batch_init(batch, batch->asid);
+}
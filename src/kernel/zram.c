@@ -0,0 +1,236 @@
+/* Compressed Page Store for MIMIX 3.1.2
+ *
+ * Functional Paradigm: Same-filled check, then compress, then pool
+ * Big O Complexity: O(PAGE) per transfer, O(1) chunk allocation
+ * Memory Optimization: 64-byte size classes bound waste per object
+ * Architecture: Span-backed free lists per class, LZ codec (lz.c)
+ */
+
+#include <headers/zram.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MIMIX_ZRAM_WORDS       (MIMIX_ZRAM_PAGE / sizeof(unsigned long))
+#define MIMIX_ZRAM_SCAN        8     /* Words compared per early-out check */
+#define MIMIX_ZRAM_SPAN_HEAD   MIMIX_ZRAM_CLASS_STEP  /* Keeps chunks aligned */
+#define MIMIX_ZRAM_NEXT(p)     (*(unsigned char **) (p))
+
+int mimix_zram_init(mimix_zram_t *zram, unsigned long npages) {
+	int i;
+
+	memset(zram, 0, sizeof(*zram));
+	if (npages == 0) {
+		errno = EINVAL;
+		return -1;
+	}
+	zram->slots = (mimix_zram_slot_t *) calloc(npages,
+			sizeof(mimix_zram_slot_t));
+	if (zram->slots == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	zram->npages = npages;
+	for (i = 0; i < MIMIX_ZRAM_CLASSES; i++) {
+		zram->classes[i].chunk = (unsigned int) ((i + 1) * MIMIX_ZRAM_CLASS_STEP);
+		zram->classes[i].per_span = (MIMIX_ZRAM_SPAN - MIMIX_ZRAM_SPAN_HEAD)
+				/ zram->classes[i].chunk;
+	}
+	return 0;
+}
+
+void mimix_zram_destroy(mimix_zram_t *zram) {
+	int i;
+
+	for (i = 0; i < MIMIX_ZRAM_CLASSES; i++) {
+		unsigned char *span = zram->classes[i].spans;
+
+		while (span != NULL) {
+			unsigned char *next = MIMIX_ZRAM_NEXT(span);
+
+			free(span);
+			span = next;
+		}
+	}
+	free(zram->slots);
+	memset(zram, 0, sizeof(*zram));
+}
+
+/* Pop a chunk, growing the class by one span when empty
+ * Complexity: O(1) amortised, O(per_span) on growth
+ */
+static unsigned char *mimix_zram_alloc(mimix_zram_t *zram, int size_class) {
+	mimix_zram_class_t *c = &zram->classes[size_class];
+	unsigned char *chunk;
+
+	if (c->free_list == NULL) {
+		unsigned char *span = (unsigned char *) malloc(MIMIX_ZRAM_SPAN);
+		unsigned int i;
+
+		if (span == NULL) {
+			errno = ENOMEM;
+			return NULL;
+		}
+		MIMIX_ZRAM_NEXT(span) = c->spans;
+		c->spans = span;
+		c->nspans++;
+		zram->stats.pool_bytes += MIMIX_ZRAM_SPAN;
+		for (i = c->per_span; i-- > 0;) {
+			chunk = span + MIMIX_ZRAM_SPAN_HEAD + (unsigned long) i * c->chunk;
+			MIMIX_ZRAM_NEXT(chunk) = c->free_list;
+			c->free_list = chunk;
+		}
+	}
+	chunk = c->free_list;
+	c->free_list = MIMIX_ZRAM_NEXT(chunk);
+	c->used++;
+	return chunk;
+}
+
+static void mimix_zram_free(mimix_zram_t *zram, int size_class,
+		unsigned char *chunk) {
+	mimix_zram_class_t *c = &zram->classes[size_class];
+
+	MIMIX_ZRAM_NEXT(chunk) = c->free_list;
+	c->free_list = chunk;
+	c->used--;
+}
+
+/* Fast path: does one word repeat across the page?
+ * Complexity: O(PAGE) worst case, exits at the first differing block
+ */
+static int mimix_zram_same_filled(const unsigned long *words,
+		unsigned long *fill) {
+	unsigned long first = words[0];
+	size_t i, j;
+
+	for (i = 0; i < MIMIX_ZRAM_WORDS; i += MIMIX_ZRAM_SCAN) {
+		unsigned long diff = 0;
+
+		for (j = 0; j < MIMIX_ZRAM_SCAN; j++) {
+			diff |= words[i + j] ^ first;
+		}
+		if (diff != 0) {
+			return 0;
+		}
+	}
+	*fill = first;
+	return 1;
+}
+
+void mimix_zram_discard(mimix_zram_t *zram, unsigned long index) {
+	mimix_zram_slot_t *slot;
+
+	if (index >= zram->npages) {
+		return;
+	}
+	slot = &zram->slots[index];
+	switch (slot->flags) {
+	case MIMIX_ZRAM_SAME:
+		zram->stats.same_filled--;
+		break;
+	case MIMIX_ZRAM_RAW:
+		zram->stats.raw--;
+		/* Fall through */
+	case MIMIX_ZRAM_COMPRESSED:
+		mimix_zram_free(zram, slot->size_class, slot->u.object);
+		zram->stats.compressed_bytes -= slot->length;
+		break;
+	default:
+		return;
+	}
+	zram->stats.pages--;
+	memset(slot, 0, sizeof(*slot));
+}
+
+int mimix_zram_store(mimix_zram_t *zram, unsigned long index,
+		const void *page) {
+	mimix_zram_slot_t *slot;
+	const unsigned char *data = zram->buffer;
+	unsigned char *object;
+	unsigned long fill;
+	long length;
+	int size_class;
+	int flags = MIMIX_ZRAM_COMPRESSED;
+
+	if (index >= zram->npages) {
+		errno = EINVAL;
+		return -1;
+	}
+	slot = &zram->slots[index];
+
+	if (mimix_zram_same_filled((const unsigned long *) page, &fill)) {
+		mimix_zram_discard(zram, index);
+		slot->u.fill = fill;
+		slot->flags = MIMIX_ZRAM_SAME;
+		zram->stats.same_filled++;
+		zram->stats.pages++;
+		return 0;
+	}
+
+	/* Capping the output at MAX_OBJECT stops early on incompressible data */
+	length = mimix_lz_compress((const unsigned char *) page, MIMIX_ZRAM_PAGE,
+			zram->buffer, MIMIX_ZRAM_MAX_OBJECT);
+	if (length < 0) {
+		if (errno != ENOSPC) {
+			return -1;
+		}
+		data = (const unsigned char *) page;
+		length = MIMIX_ZRAM_PAGE;
+		flags = MIMIX_ZRAM_RAW;
+	}
+
+	/* Allocate before discarding so a failure keeps the old contents */
+	size_class = (int) ((length + MIMIX_ZRAM_CLASS_STEP - 1)
+			/ MIMIX_ZRAM_CLASS_STEP) - 1;
+	object = mimix_zram_alloc(zram, size_class);
+	if (object == NULL) {
+		return -1;
+	}
+	memcpy(object, data, (size_t) length);
+	mimix_zram_discard(zram, index);
+
+	slot->u.object = object;
+	slot->length = (unsigned short) length;
+	slot->size_class = (unsigned char) size_class;
+	slot->flags = (unsigned char) flags;
+	zram->stats.raw += (flags == MIMIX_ZRAM_RAW);
+	zram->stats.compressed_bytes += (unsigned long) length;
+	zram->stats.pages++;
+	return 0;
+}
+
+int mimix_zram_load(mimix_zram_t *zram, unsigned long index, void *page) {
+	mimix_zram_slot_t *slot;
+	size_t i;
+
+	if (index >= zram->npages) {
+		errno = EINVAL;
+		return -1;
+	}
+	slot = &zram->slots[index];
+	switch (slot->flags) {
+	case MIMIX_ZRAM_SAME:
+		for (i = 0; i < MIMIX_ZRAM_WORDS; i++) {
+			((unsigned long *) page)[i] = slot->u.fill;
+		}
+		return 0;
+	case MIMIX_ZRAM_RAW:
+		memcpy(page, slot->u.object, MIMIX_ZRAM_PAGE);
+		return 0;
+	case MIMIX_ZRAM_COMPRESSED:
+		if (mimix_lz_decompress(slot->u.object, slot->length,
+				(unsigned char *) page, MIMIX_ZRAM_PAGE) != MIMIX_ZRAM_PAGE) {
+			errno = EIO;
+			return -1;
+		}
+		return 0;
+	default:
+		errno = ENOENT;
+		return -1;
+	}
+}
+
+unsigned long mimix_zram_memory_used(const mimix_zram_t *zram) {
+	return zram->stats.pool_bytes + zram->npages * sizeof(mimix_zram_slot_t);
+}
@@ -0,0 +1,294 @@
+/* LZ Codec for MIMIX 3.1.2
+ *
+ * Functional Paradigm: Greedy hash matcher, bounds-checked decoder
+ * Big O Complexity: O(n) - Skip acceleration on incompressible runs
+ * Memory Optimization: 8 KiB stack hash table, no heap use
+ * SIMD Optimization: AVX2 match extension, 32 bytes per compare
+ *
+ * The matcher hashes every 4-byte window it visits, probes one candidate
+ * and extends a verified match backwards over pending literals and
+ * forwards with the widest compare available. Scanning speeds up the
+ * longer no match is found, so random data costs little before the
+ * output bound rejects it.
+ */
+
+#include <headers/lz.h>
+#include <errno.h>
+#include <string.h>
+
+#define MIMIX_LZ_HASH_SIZE     (1 << MIMIX_LZ_HASH_BITS)
+#define MIMIX_LZ_LAST_LITERALS 5     /* Block always ends in literals */
+#define MIMIX_LZ_MF_LIMIT      12    /* No match starts this close to the end */
+#define MIMIX_LZ_SKIP_TRIGGER  6     /* Step grows every 64 missed bytes */
+#define MIMIX_LZ_MAX_OFFSET    65535
+#define MIMIX_LZ_NIBBLE        15
+#define MIMIX_LZ_WILD          16    /* Fixed-size literal copy */
+
+static unsigned int mimix_lz_read32(const unsigned char *p) {
+	unsigned int v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static unsigned int mimix_lz_hash(unsigned int v) {
+	return (v * 2654435761U) >> (32 - MIMIX_LZ_HASH_BITS);
+}
+
+/* Count equal bytes at ref and ip, stopping at limit
+ * Complexity: O(m/32) with AVX2, O(m/8) otherwise
+ */
+static size_t mimix_lz_extend(const unsigned char *ref, const unsigned char *ip,
+		const unsigned char *limit) {
+	const unsigned char *start = ip;
+
+#if defined(__GNUC__) && defined(__AVX2__)
+	while (ip + sizeof(mimix_v32qi) <= limit) {
+		mimix_v32qi a, b;
+		unsigned int mask;
+
+		memcpy(&a, ref, sizeof(a));
+		memcpy(&b, ip, sizeof(b));
+		mask = (unsigned int) __builtin_ia32_pmovmskb256((mimix_v32qi) (a == b));
+		if (mask != 0xFFFFFFFFU) {
+			return (size_t) (ip - start) + (size_t) __builtin_ctz(~mask);
+		}
+		ref += sizeof(mimix_v32qi);
+		ip += sizeof(mimix_v32qi);
+	}
+#endif
+#ifdef __GNUC__
+	while (ip + sizeof(unsigned long) <= limit) {
+		unsigned long a, b;
+
+		memcpy(&a, ref, sizeof(a));
+		memcpy(&b, ip, sizeof(b));
+		if (a != b) {
+			/* Little endian: lowest differing byte is the first one */
+			return (size_t) (ip - start) + (size_t) __builtin_ctzl(a ^ b) / 8;
+		}
+		ref += sizeof(unsigned long);
+		ip += sizeof(unsigned long);
+	}
+#endif
+	while (ip < limit && *ref == *ip) {
+		ref++;
+		ip++;
+	}
+	return (size_t) (ip - start);
+}
+
+/* Continue a length that overflowed its nibble
+ * Complexity: O(n/255)
+ */
+static unsigned char *mimix_lz_put_length(unsigned char *op, size_t n) {
+	while (n >= 255) {
+		*op++ = 255;
+		n -= 255;
+	}
+	*op++ = (unsigned char) n;
+	return op;
+}
+
+static int mimix_lz_get_length(const unsigned char **ip,
+		const unsigned char *iend, size_t *n) {
+	unsigned int b;
+
+	do {
+		if (*ip >= iend) {
+			return -1;
+		}
+		b = *(*ip)++;
+		*n += b;
+	} while (b == 255);
+	return 0;
+}
+
+/* Emit one sequence; match length 0 marks the literal-only tail
+ * Complexity: O(lit)
+ */
+static unsigned char *mimix_lz_emit(unsigned char *op, unsigned char *oend,
+		const unsigned char *anchor, size_t lit, size_t offset, size_t mlen) {
+	size_t ml = (mlen > 0) ? mlen - MIMIX_LZ_MIN_MATCH : 0;
+	unsigned char *token;
+
+	if ((size_t) (oend - op) < 1 + lit / 255 + 1 + lit + 2 + ml / 255 + 1) {
+		return NULL;
+	}
+	token = op++;
+	*token = (unsigned char) ((lit < MIMIX_LZ_NIBBLE ? lit : MIMIX_LZ_NIBBLE)
+			<< 4);
+	if (lit >= MIMIX_LZ_NIBBLE) {
+		op = mimix_lz_put_length(op, lit - MIMIX_LZ_NIBBLE);
+	}
+	memcpy(op, anchor, lit);
+	op += lit;
+	if (mlen == 0) {
+		return op;
+	}
+	*op++ = (unsigned char) (offset & 0xFF);
+	*op++ = (unsigned char) (offset >> 8);
+	*token |= (unsigned char) (ml < MIMIX_LZ_NIBBLE ? ml : MIMIX_LZ_NIBBLE);
+	if (ml >= MIMIX_LZ_NIBBLE) {
+		op = mimix_lz_put_length(op, ml - MIMIX_LZ_NIBBLE);
+	}
+	return op;
+}
+
+long mimix_lz_compress(const unsigned char *src, size_t len,
+		unsigned char *dst, size_t cap) {
+	unsigned short table[MIMIX_LZ_HASH_SIZE];
+	const unsigned char *ip = src;
+	const unsigned char *anchor = src;
+	const unsigned char *end = src + len;
+	unsigned char *op = dst;
+	unsigned char *oend = dst + cap;
+
+	if (len > MIMIX_LZ_MAX_INPUT) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (len > MIMIX_LZ_MF_LIMIT) {
+		const unsigned char *mflimit = end - MIMIX_LZ_MF_LIMIT;
+		const unsigned char *matchlimit = end - MIMIX_LZ_LAST_LITERALS;
+
+		/* Zeroed slots point at src[0], which the 4-byte check verifies */
+		memset(table, 0, sizeof(table));
+		ip++;
+		while (ip < mflimit) {
+			unsigned int seq = mimix_lz_read32(ip);
+			unsigned int h = mimix_lz_hash(seq);
+			const unsigned char *ref = src + table[h];
+			size_t mlen;
+
+			table[h] = (unsigned short) (ip - src);
+			if (ref >= ip || ip - ref > MIMIX_LZ_MAX_OFFSET
+					|| mimix_lz_read32(ref) != seq) {
+				ip += 1 + ((size_t) (ip - anchor) >> MIMIX_LZ_SKIP_TRIGGER);
+				continue;
+			}
+
+			while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+				ip--;
+				ref--;
+			}
+			mlen = MIMIX_LZ_MIN_MATCH + mimix_lz_extend(ref + MIMIX_LZ_MIN_MATCH,
+					ip + MIMIX_LZ_MIN_MATCH, matchlimit);
+			op = mimix_lz_emit(op, oend, anchor, (size_t) (ip - anchor),
+					(size_t) (ip - ref), mlen);
+			if (op == NULL) {
+				errno = ENOSPC;
+				return -1;
+			}
+			ip += mlen;
+			anchor = ip;
+			if (ip < mflimit) {
+				table[mimix_lz_hash(mimix_lz_read32(ip - 2))] =
+						(unsigned short) (ip - 2 - src);
+			}
+		}
+	}
+
+	op = mimix_lz_emit(op, oend, anchor, (size_t) (end - anchor), 0, 0);
+	if (op == NULL) {
+		errno = ENOSPC;
+		return -1;
+	}
+	return (long) (op - dst);
+}
+
+long mimix_lz_decompress(const unsigned char *src, size_t len,
+		unsigned char *dst, size_t cap) {
+	const unsigned char *ip = src;
+	const unsigned char *iend = src + len;
+	unsigned char *op = dst;
+	unsigned char *oend = dst + cap;
+
+	for (;;) {
+		const unsigned char *ref;
+		unsigned int token;
+		size_t lit, mlen, offset;
+
+		if (ip >= iend) {
+			errno = EINVAL;
+			return -1;
+		}
+		token = *ip++;
+
+		lit = token >> 4;
+
+		/* Short literal run with slack on both sides: one fixed copy */
+		if (lit < MIMIX_LZ_NIBBLE && iend - ip >= MIMIX_LZ_WILD
+				&& oend - op >= MIMIX_LZ_WILD) {
+			memcpy(op, ip, MIMIX_LZ_WILD);
+		} else {
+			if (lit == MIMIX_LZ_NIBBLE
+					&& mimix_lz_get_length(&ip, iend, &lit) != 0) {
+				errno = EINVAL;
+				return -1;
+			}
+			if ((size_t) (iend - ip) < lit) {
+				errno = EINVAL;
+				return -1;
+			}
+			if ((size_t) (oend - op) < lit) {
+				errno = ENOSPC;
+				return -1;
+			}
+			memcpy(op, ip, lit);
+		}
+		op += lit;
+		ip += lit;
+		if (ip == iend) {
+			break;  /* Literal-only tail */
+		}
+
+		if (iend - ip < 2) {
+			errno = EINVAL;
+			return -1;
+		}
+		offset = (size_t) ip[0] | ((size_t) ip[1] << 8);
+		ip += 2;
+		mlen = token & MIMIX_LZ_NIBBLE;
+		if ((mlen == MIMIX_LZ_NIBBLE && mimix_lz_get_length(&ip, iend, &mlen)
+				!= 0) || offset == 0 || offset > (size_t) (op - dst)) {
+			errno = EINVAL;
+			return -1;
+		}
+		mlen += MIMIX_LZ_MIN_MATCH;
+		if ((size_t) (oend - op) < mlen) {
+			errno = ENOSPC;
+			return -1;
+		}
+
+		/* Overlapping copies replicate the period, so go bytewise below 8 */
+		ref = op - offset;
+		if (offset >= sizeof(unsigned long)
+				&& (size_t) (oend - op) >= mlen + sizeof(unsigned long)) {
+			unsigned char *mend = op + mlen;
+
+			/* Slack after the match absorbs the overshoot of the last word */
+			do {
+				memcpy(op, ref, sizeof(unsigned long));
+				op += sizeof(unsigned long);
+				ref += sizeof(unsigned long);
+			} while (op < mend);
+			op = mend;
+			continue;
+		}
+		if (offset >= sizeof(unsigned long)) {
+			while (mlen >= sizeof(unsigned long)) {
+				memcpy(op, ref, sizeof(unsigned long));
+				op += sizeof(unsigned long);
+				ref += sizeof(unsigned long);
+				mlen -= sizeof(unsigned long);
+			}
+		}
+		while (mlen > 0) {
+			*op++ = *ref++;
+			mlen--;
+		}
+	}
+	return (long) (op - dst);
+}
@@ -0,0 +1,258 @@
+/* Hardware Performance Counters for MIMIX 3.1.2
+ *
+ * Functional Paradigm: Side effects confined to the counter descriptors
+ * Big O Complexity: O(n) open/close, O(1) syscalls per begin/end
+ * Architecture: Linux perf_event_open(2) counter groups, user space only
+ *
+ * The group is read with PERF_FORMAT_GROUP | PERF_FORMAT_ID so a partially
+ * opened group still maps every value back to its counter index.
+ */
+
+#include <headers/perf.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+/* Counter Configuration Table
+ * Hardware cache events encode (cache id) | (op << 8) | (result << 16).
+ */
+static const struct mimix_perf_event {
+	const char *name;
+	unsigned int type;
+	unsigned long config;
+} mimix_perf_events[MIMIX_PERF_NCOUNTERS] = {
+	{ "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+	{ "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+	{ "L1D-misses", PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+			| (PERF_COUNT_HW_CACHE_OP_READ << 8)
+			| (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+	{ "LLC-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+	{ "branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+	{ "dTLB-misses", PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB
+			| (PERF_COUNT_HW_CACHE_OP_READ << 8)
+			| (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) }
+};
+
+/* Boundness heuristics (misses per kilo-instruction) */
+#define MIMIX_PERF_MEMBOUND_IPC    1.0
+#define MIMIX_PERF_MEMBOUND_LLC    1.0
+#define MIMIX_PERF_MEMBOUND_DTLB   1.0
+
+/* Monotonic clock in nanoseconds
+ * Complexity: O(1) - Single vDSO call
+ */
+static unsigned long mimix_perf_now_ns(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long) ts.tv_sec * 1000000000UL
+			+ (unsigned long) ts.tv_nsec;
+}
+
+/* Open one counter, joining the group led by group_fd
+ * Complexity: O(1) - Single system call
+ */
+static int mimix_perf_open_counter(int counter, int group_fd) {
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.type = mimix_perf_events[counter].type;
+	attr.size = sizeof(attr);
+	attr.config = mimix_perf_events[counter].config;
+	attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID
+			| PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	attr.disabled = (group_fd == -1) ? 1 : 0;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+
+	return (int) syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+int mimix_perf_open(mimix_perf_group_t *group) {
+	int i;
+	int opened = 0;
+
+	memset(group, 0, sizeof(*group));
+	for (i = 0; i < MIMIX_PERF_NCOUNTERS; i++) {
+		group->fd[i] = -1;
+	}
+
+	group->fd[0] = mimix_perf_open_counter(0, -1);
+	if (group->fd[0] < 0) {
+		group->fd[0] = -1;
+		return 0;
+	}
+
+	for (i = 0; i < MIMIX_PERF_NCOUNTERS; i++) {
+		if (i > 0) {
+			group->fd[i] = mimix_perf_open_counter(i, group->fd[0]);
+		}
+		if (group->fd[i] < 0) {
+			group->fd[i] = -1;
+			continue;
+		}
+		if (ioctl(group->fd[i], PERF_EVENT_IOC_ID, &group->id[i]) != 0) {
+			close(group->fd[i]);
+			group->fd[i] = -1;
+			continue;
+		}
+		group->opened_mask |= 1UL << i;
+		opened++;
+	}
+
+	group->available = (group->opened_mask & 1UL) ? 1 : 0;
+	return opened;
+}
+
+void mimix_perf_close(mimix_perf_group_t *group) {
+	int i;
+
+	/* Members first, leader last */
+	for (i = MIMIX_PERF_NCOUNTERS - 1; i >= 0; i--) {
+		if (group->fd[i] >= 0) {
+			close(group->fd[i]);
+			group->fd[i] = -1;
+		}
+	}
+	group->opened_mask = 0;
+	group->available = 0;
+}
+
+void mimix_perf_begin(mimix_perf_group_t *group) {
+	if (group->available) {
+		ioctl(group->fd[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	}
+	group->start_ns = mimix_perf_now_ns();
+	if (group->available) {
+		ioctl(group->fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	}
+}
+
+void mimix_perf_end(mimix_perf_group_t *group, mimix_perf_sample_t *sample) {
+	/* nr, time_enabled, time_running, then {value, id} per counter */
+	unsigned long buf[3 + 2 * MIMIX_PERF_NCOUNTERS];
+	unsigned long i;
+	int j;
+
+	if (group->available) {
+		ioctl(group->fd[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+	}
+	sample->wall_ns = mimix_perf_now_ns() - group->start_ns;
+
+	memset(sample->value, 0, sizeof(sample->value));
+	sample->valid_mask = 0;
+	sample->multiplexed = 0;
+	if (!group->available) {
+		return;
+	}
+
+	if (read(group->fd[0], buf, sizeof(buf)) < (ssize_t) (3 * sizeof(buf[0]))
+			|| buf[0] > MIMIX_PERF_NCOUNTERS || buf[2] == 0) {
+		/* Group never got onto the PMU: report no counters */
+		return;
+	}
+
+	sample->multiplexed = (buf[2] < buf[1]) ? 1 : 0;
+	for (i = 0; i < buf[0]; i++) {
+		unsigned long value = buf[3 + 2 * i];
+		unsigned long id = buf[4 + 2 * i];
+
+		if (sample->multiplexed) {
+			value = (unsigned long) ((double) value * (double) buf[1]
+					/ (double) buf[2]);
+		}
+		for (j = 0; j < MIMIX_PERF_NCOUNTERS; j++) {
+			if ((group->opened_mask & (1UL << j)) && group->id[j] == id) {
+				sample->value[j] = value;
+				sample->valid_mask |= 1UL << j;
+				break;
+			}
+		}
+	}
+}
+
+double mimix_perf_ipc(const mimix_perf_sample_t *sample) {
+	unsigned long need = (1UL << MIMIX_PERF_CYCLES)
+			| (1UL << MIMIX_PERF_INSTRUCTIONS);
+
+	if ((sample->valid_mask & need) != need
+			|| sample->value[MIMIX_PERF_CYCLES] == 0) {
+		return -1.0;
+	}
+	return (double) sample->value[MIMIX_PERF_INSTRUCTIONS]
+			/ (double) sample->value[MIMIX_PERF_CYCLES];
+}
+
+double mimix_perf_mpki(const mimix_perf_sample_t *sample, int counter) {
+	unsigned long need;
+
+	if (counter < 0 || counter >= MIMIX_PERF_NCOUNTERS) {
+		return -1.0;
+	}
+	need = (1UL << MIMIX_PERF_INSTRUCTIONS) | (1UL << counter);
+	if ((sample->valid_mask & need) != need
+			|| sample->value[MIMIX_PERF_INSTRUCTIONS] == 0) {
+		return -1.0;
+	}
+	return 1000.0 * (double) sample->value[counter]
+			/ (double) sample->value[MIMIX_PERF_INSTRUCTIONS];
+}
+
+const char *mimix_perf_boundness(const mimix_perf_sample_t *sample) {
+	double ipc = mimix_perf_ipc(sample);
+	double llc = mimix_perf_mpki(sample, MIMIX_PERF_LLC_MISSES);
+	double dtlb = mimix_perf_mpki(sample, MIMIX_PERF_DTLB_MISSES);
+
+	if (ipc < 0.0 || (llc < 0.0 && dtlb < 0.0)) {
+		return "-";
+	}
+	if (ipc < MIMIX_PERF_MEMBOUND_IPC
+			&& (llc >= MIMIX_PERF_MEMBOUND_LLC
+					|| dtlb >= MIMIX_PERF_MEMBOUND_DTLB)) {
+		return "memory";
+	}
+	return "compute";
+}
+
+const char *mimix_perf_counter_name(int counter) {
+	if (counter < 0 || counter >= MIMIX_PERF_NCOUNTERS) {
+		return "unknown";
+	}
+	return mimix_perf_events[counter].name;
+}
+
+/* Print one derived value or a placeholder
+ * Complexity: O(1)
+ */
+static void mimix_perf_print_metric(FILE *out, double value) {
+	if (value < 0.0) {
+		fprintf(out, " %8s", "n/a");
+	} else {
+		fprintf(out, " %8.2f", value);
+	}
+}
+
+void mimix_perf_print_header(FILE *out) {
+	fprintf(out, "%-25s %10s %8s %8s %8s %8s %8s %8s\n", "Case", "wall(us)",
+			"IPC", "L1D/KI", "LLC/KI", "BR/KI", "DTLB/KI", "bound");
+}
+
+void mimix_perf_print_row(FILE *out, const char *name,
+		const mimix_perf_sample_t *sample) {
+	fprintf(out, "%-25s %10.1f", name, (double) sample->wall_ns / 1000.0);
+	mimix_perf_print_metric(out, mimix_perf_ipc(sample));
+	mimix_perf_print_metric(out,
+			mimix_perf_mpki(sample, MIMIX_PERF_L1D_MISSES));
+	mimix_perf_print_metric(out,
+			mimix_perf_mpki(sample, MIMIX_PERF_LLC_MISSES));
+	mimix_perf_print_metric(out,
+			mimix_perf_mpki(sample, MIMIX_PERF_BRANCH_MISSES));
+	mimix_perf_print_metric(out,
+			mimix_perf_mpki(sample, MIMIX_PERF_DTLB_MISSES));
+	fprintf(out, " %8s%s\n", mimix_perf_boundness(sample),
+			sample->multiplexed ? " *" : "");
+}
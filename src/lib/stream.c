@@ -0,0 +1,393 @@
+/* Streaming I/O for MIMIX 3.1.2
+ *
+ * Functional Paradigm: Producer/consumer over immutable slices
+ * Big O Complexity: O(1) per slice hand-off, O(n) bytes via the kernel
+ * Architecture: mmap(2)/madvise(2) or pread(2) workers with a slot ring
+ *
+ * pread slot states move EMPTY -> FILLING (worker) -> READY -> EMPTY
+ * (consumer releases on its next call). Chunk seq always lives in slot
+ * seq % MIMIX_STREAM_IO_SLOTS, so ordering needs no extra bookkeeping.
+ */
+
+#include <headers/stream.h>
+#include <headers/trace.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define MIMIX_SLOT_EMPTY    0
+#define MIMIX_SLOT_FILLING  1
+#define MIMIX_SLOT_READY    2
+
+/* Read exactly len bytes at offset unless EOF intervenes
+ * Complexity: O(n) - Retries short reads and EINTR
+ */
+static ssize_t mimix_stream_pread_full(int fd, unsigned char *buf, size_t len,
+		unsigned long offset) {
+	size_t done = 0;
+
+	while (done < len) {
+		ssize_t got = pread(fd, buf + done, len - done,
+				(off_t) (offset + done));
+
+		if (got < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -1;
+		}
+		if (got == 0) {
+			break;
+		}
+		done += (size_t) got;
+	}
+	return (ssize_t) done;
+}
+
+/* pread Worker: claim the next chunk, fill its slot, publish it
+ * Complexity: O(n/k) chunks per worker for k workers
+ */
+static void *mimix_stream_worker(void *arg) {
+	mimix_stream_reader_t *r = (mimix_stream_reader_t *) arg;
+
+	pthread_mutex_lock(&r->lock);
+	for (;;) {
+		mimix_stream_slot_t *slot;
+		unsigned long seq;
+		ssize_t got;
+
+		while (!r->stop && r->next_fill < r->nchunks
+				&& r->slots[r->next_fill % MIMIX_STREAM_IO_SLOTS].state
+						!= MIMIX_SLOT_EMPTY) {
+			pthread_cond_wait(&r->drained, &r->lock);
+		}
+		if (r->stop || r->next_fill >= r->nchunks) {
+			break;
+		}
+
+		seq = r->next_fill++;
+		slot = &r->slots[seq % MIMIX_STREAM_IO_SLOTS];
+		slot->state = MIMIX_SLOT_FILLING;
+		slot->seq = seq;
+		pthread_mutex_unlock(&r->lock);
+
+		got = mimix_stream_pread_full(r->fd, slot->data, r->chunk,
+				seq * r->chunk);
+
+		pthread_mutex_lock(&r->lock);
+		if (got < 0) {
+			if (r->error == 0) {
+				r->error = errno;
+			}
+			slot->len = 0;
+		} else {
+			slot->len = (size_t) got;
+		}
+		slot->state = MIMIX_SLOT_READY;
+		pthread_cond_broadcast(&r->filled);
+	}
+	pthread_mutex_unlock(&r->lock);
+
+	return NULL;
+}
+
+/* Start the pread pool and its slot ring
+ * Complexity: O(k) - One allocation per slot, one thread per worker
+ */
+static int mimix_stream_start_pool(mimix_stream_reader_t *r) {
+	int i;
+
+	pthread_mutex_init(&r->lock, NULL);
+	pthread_cond_init(&r->filled, NULL);
+	pthread_cond_init(&r->drained, NULL);
+	r->held = -1;
+
+	for (i = 0; i < MIMIX_STREAM_IO_SLOTS; i++) {
+		void *data = NULL;
+
+		if (posix_memalign(&data, _MIMIX_ALIGNMENT, r->chunk) != 0) {
+			errno = ENOMEM;
+			return -1;
+		}
+		r->slots[i].data = (unsigned char *) data;
+		r->slots[i].state = MIMIX_SLOT_EMPTY;
+	}
+
+	for (i = 0; i < MIMIX_STREAM_IO_THREADS; i++) {
+		if (pthread_create(&r->threads[i], NULL, mimix_stream_worker, r)
+				!= 0) {
+			errno = EAGAIN;
+			return -1;
+		}
+		r->nthreads++;
+	}
+	return 0;
+}
+
+int mimix_stream_open(mimix_stream_reader_t *r, const char *path, int flags,
+		size_t chunk) {
+	struct stat st;
+	long page = sysconf(_SC_PAGESIZE);
+
+	memset(r, 0, sizeof(*r));
+	r->held = -1;
+	r->fd = open(path, O_RDONLY);
+	if (r->fd < 0) {
+		return -1;
+	}
+	if (fstat(r->fd, &st) != 0) {
+		close(r->fd);
+		r->fd = -1;
+		return -1;
+	}
+
+	/* Slices must start on page boundaries for madvise */
+	if (chunk == 0) {
+		chunk = MIMIX_STREAM_CHUNK;
+	}
+	r->chunk = (chunk + (size_t) page - 1) & ~((size_t) page - 1);
+	r->size = (unsigned long) st.st_size;
+	r->nchunks = (r->size + r->chunk - 1) / r->chunk;
+
+	if (flags == MIMIX_STREAM_FORCE_PREAD
+			|| (flags == MIMIX_STREAM_AUTO && r->size > MIMIX_STREAM_MAP_LIMIT)) {
+		r->mode = MIMIX_STREAM_MODE_PREAD;
+		posix_fadvise(r->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+		if (mimix_stream_start_pool(r) != 0) {
+			int saved = errno;
+
+			mimix_stream_close(r);
+			errno = saved;
+			return -1;
+		}
+		return 0;
+	}
+
+	r->mode = MIMIX_STREAM_MODE_MMAP;
+	if (r->size == 0) {
+		return 0;  /* Nothing to map; first next() reports EOF */
+	}
+	r->map = (const unsigned char *) mmap(NULL, (size_t) r->size, PROT_READ,
+			MAP_PRIVATE, r->fd, 0);
+	if (r->map == (const unsigned char *) MAP_FAILED) {
+		int saved = errno;
+
+		r->map = NULL;
+		mimix_stream_close(r);
+		errno = saved;
+		return -1;
+	}
+	madvise((void *) r->map, (size_t) r->size, MADV_SEQUENTIAL);
+	madvise((void *) r->map, r->chunk < r->size ? r->chunk : (size_t) r->size,
+			MADV_WILLNEED);
+	return 0;
+}
+
+/* mmap slice: window into the mapping, prefetch the following chunk
+ * Complexity: O(1)
+ */
+static int mimix_stream_next_mapped(mimix_stream_reader_t *r,
+		mimix_slice_t *slice) {
+	unsigned long offset = r->next_read * r->chunk;
+	unsigned long ahead = offset + r->chunk;
+
+	slice->offset = offset;
+	slice->data = r->map + offset;
+	slice->len = (size_t) ((r->size - offset < r->chunk) ?
+			r->size - offset : r->chunk);
+
+	if (ahead < r->size) {
+		madvise((void *) (r->map + ahead), (size_t) ((r->size - ahead
+				< r->chunk) ? r->size - ahead : r->chunk), MADV_WILLNEED);
+	}
+	r->next_read++;
+	return 1;
+}
+
+/* pread slice: release the held slot, wait for the next one in order
+ * Complexity: O(1) amortised - Blocks only when workers fall behind
+ */
+static int mimix_stream_next_pooled(mimix_stream_reader_t *r,
+		mimix_slice_t *slice) {
+	mimix_stream_slot_t *slot;
+	int index;
+
+	pthread_mutex_lock(&r->lock);
+	if (r->held >= 0) {
+		r->slots[r->held].state = MIMIX_SLOT_EMPTY;
+		r->held = -1;
+		pthread_cond_broadcast(&r->drained);
+	}
+	if (r->next_read >= r->nchunks) {
+		pthread_mutex_unlock(&r->lock);
+		return 0;
+	}
+
+	index = (int) (r->next_read % MIMIX_STREAM_IO_SLOTS);
+	slot = &r->slots[index];
+	while (r->error == 0 && (slot->state != MIMIX_SLOT_READY
+			|| slot->seq != r->next_read)) {
+		pthread_cond_wait(&r->filled, &r->lock);
+	}
+	if (r->error != 0) {
+		errno = r->error;
+		pthread_mutex_unlock(&r->lock);
+		return -1;
+	}
+
+	slice->offset = r->next_read * r->chunk;
+	slice->data = slot->data;
+	slice->len = slot->len;
+	r->held = index;
+	r->next_read++;
+	pthread_mutex_unlock(&r->lock);
+
+	return 1;
+}
+
+int mimix_stream_next(mimix_stream_reader_t *r, mimix_slice_t *slice) {
+	_TRACE_SCOPE("stream_next");
+
+	if (r->mode == MIMIX_STREAM_MODE_PREAD) {
+		return mimix_stream_next_pooled(r, slice);
+	}
+	if (r->next_read >= r->nchunks) {
+		return 0;
+	}
+	return mimix_stream_next_mapped(r, slice);
+}
+
+void mimix_stream_close(mimix_stream_reader_t *r) {
+	int i;
+
+	if (r->mode == MIMIX_STREAM_MODE_PREAD) {
+		pthread_mutex_lock(&r->lock);
+		r->stop = 1;
+		pthread_cond_broadcast(&r->drained);
+		pthread_mutex_unlock(&r->lock);
+		for (i = 0; i < r->nthreads; i++) {
+			pthread_join(r->threads[i], NULL);
+		}
+		for (i = 0; i < MIMIX_STREAM_IO_SLOTS; i++) {
+			free(r->slots[i].data);
+			r->slots[i].data = NULL;
+		}
+		pthread_cond_destroy(&r->drained);
+		pthread_cond_destroy(&r->filled);
+		pthread_mutex_destroy(&r->lock);
+		r->nthreads = 0;
+	}
+	if (r->map != NULL) {
+		munmap((void *) r->map, (size_t) r->size);
+		r->map = NULL;
+	}
+	if (r->fd >= 0) {
+		close(r->fd);
+		r->fd = -1;
+	}
+	r->mode = 0;
+}
+
+/* Write the whole buffer, retrying short writes and EINTR
+ * Complexity: O(n)
+ */
+static int mimix_stream_write_full(int fd, const unsigned char *data,
+		size_t len) {
+	while (len > 0) {
+		ssize_t put = write(fd, data, len);
+
+		if (put < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -1;
+		}
+		data += put;
+		len -= (size_t) put;
+	}
+	return 0;
+}
+
+int mimix_stream_writer_open(mimix_stream_writer_t *w, const char *path) {
+	void *buf = NULL;
+
+	memset(w, 0, sizeof(*w));
+	if (posix_memalign(&buf, _MIMIX_ALIGNMENT, MIMIX_STREAM_WRITE_BUFFER)
+			!= 0) {
+		errno = ENOMEM;
+		return -1;
+	}
+	w->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (w->fd < 0) {
+		free(buf);
+		return -1;
+	}
+	w->buf = (unsigned char *) buf;
+	w->cap = MIMIX_STREAM_WRITE_BUFFER;
+	return 0;
+}
+
+int mimix_stream_write(mimix_stream_writer_t *w, const void *data, size_t len) {
+	const unsigned char *src = (const unsigned char *) data;
+
+	w->written += len;
+
+	/* Top up the pending buffer first so output order is preserved */
+	if (w->len > 0) {
+		size_t room = w->cap - w->len;
+		size_t take = (len < room) ? len : room;
+
+		memcpy(w->buf + w->len, src, take);
+		w->len += take;
+		src += take;
+		len -= take;
+		if (w->len < w->cap) {
+			return 0;
+		}
+		if (mimix_stream_flush(w) != 0) {
+			return -1;
+		}
+	}
+
+	/* Whole buffers go straight to the kernel */
+	if (len >= w->cap) {
+		size_t direct = len - len % w->cap;
+
+		if (mimix_stream_write_full(w->fd, src, direct) != 0) {
+			return -1;
+		}
+		src += direct;
+		len -= direct;
+	}
+
+	memcpy(w->buf, src, len);
+	w->len = len;
+	return 0;
+}
+
+int mimix_stream_flush(mimix_stream_writer_t *w) {
+	if (w->len == 0) {
+		return 0;
+	}
+	if (mimix_stream_write_full(w->fd, w->buf, w->len) != 0) {
+		return -1;
+	}
+	w->len = 0;
+	return 0;
+}
+
+int mimix_stream_writer_close(mimix_stream_writer_t *w) {
+	int result = mimix_stream_flush(w);
+
+	if (close(w->fd) != 0) {
+		result = -1;
+	}
+	free(w->buf);
+	w->buf = NULL;
+	w->fd = -1;
+	return result;
+}
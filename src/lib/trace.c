@@ -0,0 +1,163 @@
+/* Hot-Path Tracing Runtime for MIMIX 3.1.2
+ *
+ * Functional Paradigm: Writers never synchronise; export is a pure read
+ * Big O Complexity: O(1) per event, O(n) export over retained events
+ * Architecture: TSC timestamps scaled by a startup calibration
+ *
+ * Buffers are registered on a lock-free singly linked list the first time
+ * a thread records an event and live until mimix_trace_shutdown().
+ */
+
+#include <headers/trace.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+/* Calibration window: long enough for sub-0.1% error on the TSC rate */
+#define MIMIX_TRACE_CALIBRATE_NS   20000000UL
+
+_THREAD_LOCAL mimix_trace_buffer_t *mimix_trace_tls = NULL;
+
+static mimix_trace_buffer_t *mimix_trace_buffers = NULL;
+static unsigned long mimix_trace_base_tsc = 0;
+static double mimix_trace_tick_ns = 1.0;
+
+/* Monotonic clock in nanoseconds
+ * Complexity: O(1) - Single vDSO call
+ */
+unsigned long mimix_trace_clock_ns(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long) ts.tv_sec * 1000000000UL
+			+ (unsigned long) ts.tv_nsec;
+}
+
+int mimix_trace_init(void) {
+	unsigned long ns0, ns1, tsc0, tsc1;
+
+	ns0 = mimix_trace_clock_ns();
+	tsc0 = mimix_trace_rdtsc();
+	do {
+		ns1 = mimix_trace_clock_ns();
+	} while (ns1 - ns0 < MIMIX_TRACE_CALIBRATE_NS);
+	tsc1 = mimix_trace_rdtsc();
+
+	if (tsc1 <= tsc0) {
+		return -1;  /* TSC not usable */
+	}
+	mimix_trace_tick_ns = (double) (ns1 - ns0) / (double) (tsc1 - tsc0);
+	mimix_trace_base_tsc = tsc0;
+	return 0;
+}
+
+double mimix_trace_ns_per_tick(void) {
+	return mimix_trace_tick_ns;
+}
+
+mimix_trace_buffer_t *mimix_trace_attach(void) {
+	mimix_trace_buffer_t *buf = NULL;
+	mimix_trace_buffer_t *head;
+
+	if (posix_memalign((void **) &buf, _MIMIX_CACHE_LINE, sizeof(*buf)) != 0) {
+		abort();  /* Tracing must not silently drop a thread */
+	}
+	buf->head = 0;
+	buf->tid = (unsigned long) syscall(SYS_gettid);
+
+	/* Lock-free push onto the registration list */
+	head = __atomic_load_n(&mimix_trace_buffers, __ATOMIC_RELAXED);
+	do {
+		buf->next = head;
+	} while (!__atomic_compare_exchange_n(&mimix_trace_buffers, &head, buf, 1,
+			__ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+	mimix_trace_tls = buf;
+	return buf;
+}
+
+unsigned long mimix_trace_overwritten(void) {
+	mimix_trace_buffer_t *buf;
+	unsigned long lost = 0;
+
+	for (buf = __atomic_load_n(&mimix_trace_buffers, __ATOMIC_ACQUIRE);
+			buf != NULL; buf = buf->next) {
+		unsigned long head = __atomic_load_n(&buf->head, __ATOMIC_ACQUIRE);
+
+		if (head > MIMIX_TRACE_BUFFER_EVENTS) {
+			lost += head - MIMIX_TRACE_BUFFER_EVENTS;
+		}
+	}
+	return lost;
+}
+
+/* Write a JSON string literal, escaping quotes and control characters
+ * Complexity: O(n) - Single pass over the name
+ */
+static void mimix_trace_json_string(FILE *out, const char *s) {
+	fputc('"', out);
+	for (; *s != '\0'; s++) {
+		if (*s == '"' || *s == '\\') {
+			fputc('\\', out);
+			fputc(*s, out);
+		} else if ((unsigned char) *s < 0x20) {
+			fprintf(out, "\\u%04x", (unsigned int) (unsigned char) *s);
+		} else {
+			fputc(*s, out);
+		}
+	}
+	fputc('"', out);
+}
+
+int mimix_trace_export_chrome(const char *path) {
+	mimix_trace_buffer_t *buf;
+	FILE *out;
+	int first = 1;
+	long pid = (long) getpid();
+
+	out = fopen(path, "w");
+	if (out == NULL) {
+		return -1;
+	}
+
+	fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+	for (buf = __atomic_load_n(&mimix_trace_buffers, __ATOMIC_ACQUIRE);
+			buf != NULL; buf = buf->next) {
+		unsigned long head = __atomic_load_n(&buf->head, __ATOMIC_ACQUIRE);
+		unsigned long i = (head > MIMIX_TRACE_BUFFER_EVENTS) ?
+				head - MIMIX_TRACE_BUFFER_EVENTS : 0;
+
+		for (; i < head; i++) {
+			const mimix_trace_event_t *ev =
+					&buf->events[i & (MIMIX_TRACE_BUFFER_EVENTS - 1)];
+			double ts_us = (double) (long) ((ev->stamp >> 1)
+					- mimix_trace_base_tsc) * mimix_trace_tick_ns / 1000.0;
+
+			fprintf(out, "%s\n{\"name\":", first ? "" : ",");
+			mimix_trace_json_string(out, ev->name);
+			fprintf(out, ",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%ld,\"tid\":%lu}",
+					(ev->stamp & 1UL) ? MIMIX_TRACE_PHASE_END
+							: MIMIX_TRACE_PHASE_BEGIN, ts_us, pid, buf->tid);
+			first = 0;
+		}
+	}
+	fprintf(out, "\n]}\n");
+
+	return (fclose(out) == 0) ? 0 : -1;
+}
+
+void mimix_trace_shutdown(void) {
+	mimix_trace_buffer_t *buf;
+
+	buf = __atomic_exchange_n(&mimix_trace_buffers, NULL, __ATOMIC_ACQ_REL);
+	while (buf != NULL) {
+		mimix_trace_buffer_t *next = buf->next;
+
+		free(buf);
+		buf = next;
+	}
+	mimix_trace_tls = NULL;
+}
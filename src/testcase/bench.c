@@ -0,0 +1,294 @@
+/* Benchmark Suite for MIMIX 3.1.2
+ *
+ * Functional Testing: Throughput and latency kernels for each subsystem
+ * Big O Analysis: Problem sizes are set per kernel, -q selects small ones
+ * Memory Testing: Hardware counters recorded per kernel and per phase
+ *
+ * Usage: mimix-bench [-q] [-r runs] [-w baseline.json | -b baseline.json]
+ *                    [-a alpha] [-e min-effect-percent] [-t] [kernel ...]
+ *
+ * With -r the selected kernels run round-robin, so slow drift on the
+ * host spreads over every kernel instead of biasing the last one. -w
+ * stores every sample as a baseline; -b compares against one and exits
+ * with BENCH_EXIT_REGRESSED when any metric regressed. -t runs no
+ * kernels: it checks on synthetic data that the given runs and alpha
+ * still catch one clearly regressed metric.
+ */
+
+#include <headers/perf.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bench.h"
+
+/* Kernel Table */
+static const struct bench_entry {
+	const char *name;
+	bench_kernel_t kernel;
+	const char *description;
+} bench_table[] = {
+	{ "stream", bench_stream, "Sequential scan: mmap / pread pool vs fread" },
+	{ "ipc", bench_ipc, "Cross-process ping-pong: memfd grants vs AF_UNIX" },
+	{ "event", bench_event, "Event dispatch latency vs rate, with coalescing" },
+	{ "paging", bench_paging, "Translation: 4 KiB vs 2 MiB layouts, shootdowns" },
+	{ "zram", bench_zram, "Compressed page store: ratio, codec speed, savings" },
+	{ "snapshot", bench_snapshot, "Startup: cold init vs mapped state image" }
+};
+
+#define BENCH_NKERNELS ((int) (sizeof(bench_table) / sizeof(bench_table[0])))
+
+/* Regression defaults */
+#define BENCH_REGRESS_RUNS   10
+#define BENCH_REGRESS_ALPHA  0.05    /* False discovery rate */
+#define BENCH_REGRESS_EFFECT 5.0     /* Percent change of the median */
+#define BENCH_EXIT_REGRESSED 2
+
+unsigned long bench_now_ns(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long) ts.tv_sec * 1000000000UL
+			+ (unsigned long) ts.tv_nsec;
+}
+
+unsigned long bench_env_ulong(const char *name, unsigned long fallback) {
+	const char *value = getenv(name);
+	char *end;
+	unsigned long parsed;
+
+	if (value == NULL || *value == '\0') {
+		return fallback;
+	}
+	parsed = strtoul(value, &end, 10);
+	return (*end == '\0') ? parsed : fallback;
+}
+
+void bench_metric(bench_ctx_t *ctx, const char *name, double value,
+		const char *unit, int higher_is_better) {
+	bench_metric_t *m;
+
+	if (ctx->nmetrics >= BENCH_MAX_METRICS) {
+		return;
+	}
+	m = &ctx->metrics[ctx->nmetrics++];
+	sprintf(m->name, "%.20s.%.26s", ctx->kernel, name);
+	m->value = value;
+	m->unit = unit;
+	m->higher_is_better = higher_is_better;
+}
+
+void bench_phase_begin(bench_ctx_t *ctx) {
+	mimix_perf_begin(ctx->perf);
+}
+
+void bench_phase_end(bench_ctx_t *ctx, const char *name) {
+	bench_phase_t *p;
+
+	if (ctx->nphases >= BENCH_MAX_PHASES) {
+		mimix_perf_sample_t discard;
+
+		mimix_perf_end(ctx->perf, &discard);
+		return;
+	}
+	p = &ctx->phases[ctx->nphases++];
+	mimix_perf_end(ctx->perf, &p->counters);
+	sprintf(p->name, "%.20s.%.26s", ctx->kernel, name);
+}
+
+/* Look up a kernel by name
+ * Complexity: O(n) - Linear scan of a short table
+ */
+static int bench_find(const char *name) {
+	int i;
+
+	for (i = 0; i < BENCH_NKERNELS; i++) {
+		if (strcmp(bench_table[i].name, name) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+/* Run one kernel, record its metrics, and print them in full or as one line
+ * Complexity: O(kernel)
+ */
+static int bench_run(int index, int quick, mimix_perf_group_t *perf,
+		bench_suite_t *suite, int run, int runs) {
+	bench_ctx_t *ctx;
+	unsigned long start;
+	double wall_ms;
+	int status;
+	int i;
+
+	ctx = (bench_ctx_t *) calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		return -1;
+	}
+	ctx->kernel = bench_table[index].name;
+	ctx->quick = quick;
+	ctx->perf = perf;
+
+	if (runs == 1) {
+		printf("\n[%s] %s\n", bench_table[index].name,
+				bench_table[index].description);
+	}
+	start = bench_now_ns();
+	status = bench_table[index].kernel(ctx);
+	wall_ms = (double) (bench_now_ns() - start) / 1e6;
+	if (status == 0) {
+		bench_suite_record(suite, ctx);
+	}
+
+	if (runs > 1) {
+		printf("  [%s] run %d/%d: %.1f ms%s\n", bench_table[index].name,
+				run + 1, runs, wall_ms, status ? " FAILED" : "");
+		free(ctx);
+		return status;
+	}
+	printf("  wall time: %.1f ms\n", wall_ms);
+	for (i = 0; i < ctx->nmetrics; i++) {
+		printf("  %-40s %14.3f %s\n", ctx->metrics[i].name,
+				ctx->metrics[i].value, ctx->metrics[i].unit);
+	}
+	printf("\n");
+	mimix_perf_print_header(stdout);
+	for (i = 0; i < ctx->nphases; i++) {
+		mimix_perf_print_row(stdout, ctx->phases[i].name,
+				&ctx->phases[i].counters);
+	}
+	if (status != 0) {
+		printf("  %s: FAILED\n", bench_table[index].name);
+	}
+
+	free(ctx);
+	return status;
+}
+
+/* Compare against a stored baseline from the same host and problem size
+ * Complexity: O(metrics * runs log runs)
+ */
+static int bench_check(const bench_suite_t *cur, const char *path,
+		double alpha, double min_effect) {
+	bench_suite_t *base = (bench_suite_t *) malloc(sizeof(bench_suite_t));
+	int regressions;
+
+	if (base == NULL || bench_suite_load(base, path) != 0) {
+		fprintf(stderr, "baseline %s: %s\n", path, strerror(errno));
+		free(base);
+		return -1;
+	}
+	if (strcmp(base->host, cur->host) != 0 || base->quick != cur->quick) {
+		fprintf(stderr, "baseline %s is for %s%s, not %s%s\n", path,
+				base->host, base->quick ? " (-q)" : "", cur->host,
+				cur->quick ? " (-q)" : "");
+		free(base);
+		return -1;
+	}
+	regressions = bench_suite_compare(base, cur, alpha, min_effect);
+	free(base);
+	return regressions;
+}
+
+int main(int argc, char **argv) {
+	mimix_perf_group_t perf;
+	bench_suite_t *suite;
+	const char *save_path = NULL;
+	const char *check_path = NULL;
+	double alpha = BENCH_REGRESS_ALPHA;
+	double min_effect = BENCH_REGRESS_EFFECT;
+	int selected[BENCH_NKERNELS * 4];
+	int nselected = 0;
+	int quick = 0;
+	int selftest = 0;
+	int runs = 0;
+	int failed = 0;
+	int regressions = 0;
+	int i, run;
+
+	for (i = 1; i < argc; i++) {
+		const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+		if (strcmp(argv[i], "-q") == 0) {
+			quick = 1;
+		} else if (strcmp(argv[i], "-t") == 0) {
+			selftest = 1;
+		} else if (strcmp(argv[i], "-r") == 0 && value != NULL) {
+			runs = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-w") == 0 && value != NULL) {
+			save_path = argv[++i];
+		} else if (strcmp(argv[i], "-b") == 0 && value != NULL) {
+			check_path = argv[++i];
+		} else if (strcmp(argv[i], "-a") == 0 && value != NULL) {
+			alpha = atof(argv[++i]);
+		} else if (strcmp(argv[i], "-e") == 0 && value != NULL) {
+			min_effect = atof(argv[++i]);
+		} else if (bench_find(argv[i]) < 0) {
+			fprintf(stderr, "unknown kernel or option: %s\n", argv[i]);
+			return EXIT_FAILURE;
+		} else if (nselected < BENCH_NKERNELS * 4) {
+			selected[nselected++] = bench_find(argv[i]);
+		}
+	}
+	if (runs == 0) {
+		runs = (save_path || check_path || selftest) ? BENCH_REGRESS_RUNS : 1;
+	}
+	if (runs < 1 || runs > BENCH_MAX_RUNS) {
+		fprintf(stderr, "runs must be 1..%d\n", BENCH_MAX_RUNS);
+		return EXIT_FAILURE;
+	}
+	if (selftest) {
+		return (bench_suite_selftest(runs, alpha, min_effect / 100.0) == 0)
+				? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+	if (nselected == 0) {
+		for (i = 0; i < BENCH_NKERNELS; i++) {
+			selected[nselected++] = i;
+		}
+	}
+	suite = (bench_suite_t *) malloc(sizeof(bench_suite_t));
+	if (suite == NULL) {
+		return EXIT_FAILURE;
+	}
+	bench_suite_init(suite, quick);
+
+	printf("MIMIX 3.1.2 Benchmark Suite\n");
+	printf("===========================\n");
+	printf("  Perf Counters: %d/%d available\n", mimix_perf_open(&perf),
+			MIMIX_PERF_NCOUNTERS);
+	if (runs > 1) {
+		printf("  Host: %s, runs: %d\n", suite->host, runs);
+	}
+
+	for (run = 0; run < runs; run++) {
+		for (i = 0; i < nselected; i++) {
+			if (bench_run(selected[i], quick, &perf, suite, run, runs) != 0) {
+				failed++;
+			}
+		}
+	}
+	mimix_perf_close(&perf);
+
+	if (save_path != NULL) {
+		if (bench_suite_save(suite, save_path) != 0) {
+			fprintf(stderr, "baseline %s: %s\n", save_path, strerror(errno));
+			failed++;
+		} else {
+			printf("\nBaseline written to %s\n", save_path);
+		}
+	}
+	if (check_path != NULL) {
+		regressions = bench_check(suite, check_path, alpha,
+				min_effect / 100.0);
+		if (regressions < 0) {
+			failed++;
+		}
+	}
+	free(suite);
+
+	if (failed) {
+		return EXIT_FAILURE;
+	}
+	return (regressions > 0) ? BENCH_EXIT_REGRESSED : EXIT_SUCCESS;
+}
@@ -0,0 +1,111 @@
+/* Benchmark Harness Interface for MIMIX 3.1.2
+ *
+ * Functional Paradigm: Kernels report named metrics, the driver aggregates
+ * Big O Complexity: O(1) per reported metric
+ * Memory Testing: Every measured case is read from a hardware counter group
+ *
+ * Each kernel is registered in bench_table[] (bench.c) in the same way
+ * handlers are registered in syscall_table. A kernel returns 0 on success
+ * and reports results through bench_metric(). Each measured case is
+ * bracketed with bench_phase_begin/end (not nested) so it gets its own
+ * row in the counter table.
+ *
+ * For regression checks the driver repeats the selected kernels, keeps
+ * every metric's samples in a bench_suite_t (regress.c), and saves or
+ * compares them as a per-host JSON baseline. A metric regresses when a
+ * one-sided Mann-Whitney U test finds it worse at false discovery rate
+ * alpha and its median moved by at least the minimum effect in the bad
+ * direction.
+ */
+
+#ifndef _MIMIX_BENCH_H
+#define _MIMIX_BENCH_H
+
+#include <headers/perf.h>
+
+#define BENCH_MAX_METRICS   64
+#define BENCH_MAX_PHASES    32
+#define BENCH_NAME_MAX      48
+#define BENCH_UNIT_MAX      16
+#define BENCH_HOST_MAX      64
+#define BENCH_MAX_RUNS      32
+#define BENCH_MAX_SERIES    512
+
+/* Metric direction */
+#define BENCH_HIGHER_BETTER 1
+#define BENCH_LOWER_BETTER  0
+
+/* One reported value */
+typedef struct bench_metric {
+	char name[BENCH_NAME_MAX];        /* "kernel.metric" */
+	double value;
+	const char *unit;
+	int higher_is_better;
+} bench_metric_t;
+
+/* One counter-bracketed phase */
+typedef struct bench_phase {
+	char name[BENCH_NAME_MAX];
+	mimix_perf_sample_t counters;
+} bench_phase_t;
+
+/* Per-Run Context handed to every kernel */
+typedef struct bench_ctx {
+	const char *kernel;               /* Name of the running kernel */
+	int quick;                        /* Reduced problem sizes */
+	mimix_perf_group_t *perf;
+	bench_metric_t metrics[BENCH_MAX_METRICS];
+	int nmetrics;
+	bench_phase_t phases[BENCH_MAX_PHASES];
+	int nphases;
+} bench_ctx_t;
+
+typedef int (*bench_kernel_t)(bench_ctx_t *ctx);
+
+/* Samples of one metric across runs */
+typedef struct bench_series {
+	char name[BENCH_NAME_MAX];
+	char unit[BENCH_UNIT_MAX];
+	int higher_is_better;
+	int nsamples;
+	double samples[BENCH_MAX_RUNS];
+} bench_series_t;
+
+/* Every series from one host and problem size, as stored in a baseline */
+typedef struct bench_suite {
+	char host[BENCH_HOST_MAX];
+	int quick;
+	int nseries;
+	bench_series_t series[BENCH_MAX_SERIES];
+} bench_suite_t;
+
+/* Reporting helpers */
+void bench_metric(bench_ctx_t *ctx, const char *name, double value,
+		const char *unit, int higher_is_better);
+void bench_phase_begin(bench_ctx_t *ctx);
+void bench_phase_end(bench_ctx_t *ctx, const char *name);
+
+/* Shared utilities */
+unsigned long bench_now_ns(void);
+unsigned long bench_env_ulong(const char *name, unsigned long fallback);
+
+/* Regression suite (regress.c) */
+void bench_suite_init(bench_suite_t *suite, int quick);
+void bench_suite_record(bench_suite_t *suite, const bench_ctx_t *ctx);
+int bench_suite_save(const bench_suite_t *suite, const char *path);
+int bench_suite_load(bench_suite_t *suite, const char *path);
+int bench_suite_compare(const bench_suite_t *base, const bench_suite_t *cur,
+		double alpha, double min_effect);
+double bench_mann_whitney(const double *base, int nbase, const double *cur,
+		int ncur);
+int bench_suite_selftest(int runs, double alpha, double min_effect);
+
+/* Kernels */
+int bench_stream(bench_ctx_t *ctx);
+int bench_ipc(bench_ctx_t *ctx);
+int bench_event(bench_ctx_t *ctx);
+int bench_paging(bench_ctx_t *ctx);
+int bench_zram(bench_ctx_t *ctx);
+int bench_snapshot(bench_ctx_t *ctx);
+
+#endif /* _MIMIX_BENCH_H */
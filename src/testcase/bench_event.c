@@ -0,0 +1,219 @@
+/* Event Dispatch Benchmark for MIMIX 3.1.2
+ *
+ * Functional Testing: Every raised event is delivered exactly once
+ * Big O Analysis: O(n log n) - Latency percentiles by sorting n samples
+ * Memory Testing: Latency vs throughput, immediate vs adaptive coalescing
+ *
+ * Environment:
+ *   MIMIX_BENCH_EVENT_MS   Duration per paced case in ms (default 500,
+ *                          100 with -q)
+ *
+ * A producer thread raises eventfd events at a fixed rate, stamping each
+ * one; the handler turns stamps into raise-to-dispatch latencies. The
+ * last rate is unpaced and measures saturation throughput.
+ */
+
+#include <headers/event.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/prctl.h>
+#include "bench.h"
+
+#define BENCH_EVENT_MS          500
+#define BENCH_EVENT_QUICK_MS    100
+#define BENCH_EVENT_UNPACED     400000  /* Events in the saturation case */
+#define BENCH_EVENT_PACE_NS     20000   /* Producer tick */
+#define BENCH_EVENT_VECTOR      0
+
+static const unsigned long bench_event_rates[] = {
+	2000, 20000, 200000, 0               /* Events per second, 0 = unpaced */
+};
+
+#define BENCH_EVENT_NRATES \
+	(sizeof(bench_event_rates) / sizeof(bench_event_rates[0]))
+
+/* One measured case */
+typedef struct bench_event_run {
+	mimix_event_loop_t loop;
+	unsigned long rate;
+	unsigned long total;
+	unsigned long *stamps;            /* Raise time per event */
+	unsigned long *latency;           /* Raise-to-dispatch per event */
+	unsigned long consumed;
+	unsigned long last_ns;            /* Time of the final dispatch */
+	int failed;
+} bench_event_run_t;
+
+static int bench_event_compare(const void *a, const void *b) {
+	unsigned long x = *(const unsigned long *) a;
+	unsigned long y = *(const unsigned long *) b;
+
+	return (x > y) - (x < y);
+}
+
+/* Handler: one call may cover many raises
+ * Complexity: O(count)
+ */
+static void bench_event_handler(unsigned int vector, unsigned long count,
+		void *arg) {
+	bench_event_run_t *run = (bench_event_run_t *) arg;
+	unsigned long now = bench_now_ns();
+	unsigned long i;
+
+	(void) vector;
+	if (run->consumed + count > run->total) {
+		run->failed = 1;
+		count = run->total - run->consumed;
+	}
+	for (i = 0; i < count; i++) {
+		run->latency[run->consumed + i] = now - run->stamps[run->consumed + i];
+	}
+	run->consumed += count;
+	if (run->consumed == run->total) {
+		run->last_ns = now;
+		mimix_event_stop(&run->loop);
+	}
+}
+
+/* Producer: raise whatever is due each tick, one write per event
+ * Complexity: O(total)
+ */
+static void *bench_event_producer(void *arg) {
+	bench_event_run_t *run = (bench_event_run_t *) arg;
+	struct timespec tick;
+	unsigned long start = bench_now_ns();
+	unsigned long sent = 0;
+
+	/* Pacing ticks are 20 us; the loop thread sets its own slack */
+	prctl(PR_SET_TIMERSLACK, 1UL, 0UL, 0UL, 0UL);
+	tick.tv_sec = 0;
+	tick.tv_nsec = BENCH_EVENT_PACE_NS;
+	while (sent < run->total) {
+		unsigned long due = run->total;
+
+		if (run->rate > 0) {
+			due = (bench_now_ns() - start) * run->rate / 1000000000UL;
+			if (due > run->total) {
+				due = run->total;
+			}
+		}
+		while (sent < due) {
+			run->stamps[sent] = bench_now_ns();
+			if (mimix_event_raise(&run->loop, BENCH_EVENT_VECTOR, 1) != 0) {
+				/* The loop would wait forever for the rest */
+				run->failed = 1;
+				mimix_event_stop(&run->loop);
+				return NULL;
+			}
+			sent++;
+		}
+		if (sent < run->total) {
+			nanosleep(&tick, NULL);
+		}
+	}
+	return NULL;
+}
+
+/* Run one rate under one coalescing limit and report its curve point
+ * Complexity: O(n log n)
+ */
+static int bench_event_case(bench_ctx_t *ctx, const char *mode,
+		unsigned long holdoff_max_ns, unsigned long rate,
+		unsigned long duration_ms) {
+	bench_event_run_t run;
+	pthread_t producer;
+	char label[24];
+	char name[BENCH_NAME_MAX];
+	unsigned long elapsed;
+	double mevents, per_pass;
+
+	memset(&run, 0, sizeof(run));
+	run.rate = rate;
+	run.total = (rate > 0) ? rate * duration_ms / 1000 : BENCH_EVENT_UNPACED;
+	run.stamps = (unsigned long *) malloc(run.total * sizeof(unsigned long));
+	run.latency = (unsigned long *) malloc(run.total * sizeof(unsigned long));
+	if (run.stamps == NULL || run.latency == NULL
+			|| mimix_event_init(&run.loop, holdoff_max_ns) != 0) {
+		free(run.stamps);
+		free(run.latency);
+		return -1;
+	}
+	if (mimix_event_register(&run.loop, BENCH_EVENT_VECTOR,
+			bench_event_handler, &run) != 0
+			|| mimix_event_add_eventfd(&run.loop, BENCH_EVENT_VECTOR) != 0) {
+		run.failed = 1;
+	}
+
+	if (rate > 0) {
+		sprintf(label, "%luk", rate / 1000);
+	} else {
+		strcpy(label, "max");
+	}
+	sprintf(name, "%s_%s", mode, label);
+
+	bench_phase_begin(ctx);
+	if (!run.failed && pthread_create(&producer, NULL, bench_event_producer,
+			&run) == 0) {
+		if (mimix_event_run(&run.loop) != 0) {
+			run.failed = 1;
+		}
+		pthread_join(producer, NULL);
+	} else {
+		run.failed = 1;
+	}
+	bench_phase_end(ctx, name);
+
+	if (!run.failed && run.consumed == run.total && run.total > 0) {
+		qsort(run.latency, run.total, sizeof(unsigned long),
+				bench_event_compare);
+		elapsed = run.last_ns - run.stamps[0];
+		mevents = (double) run.total / (double) elapsed * 1e3;
+		per_pass = (double) run.loop.stats.events
+				/ (double) run.loop.stats.passes;
+
+		printf("  %-6s %6s  %9.3f Mev/s  p50 %9.1f us  p99 %9.1f us"
+				"  %7.1f ev/pass\n", mode, label, mevents,
+				(double) run.latency[run.total / 2] / 1e3,
+				(double) run.latency[run.total * 99 / 100] / 1e3, per_pass);
+		sprintf(name, "%s_%s_p50", mode, label);
+		bench_metric(ctx, name, (double) run.latency[run.total / 2] / 1e3,
+				"us", BENCH_LOWER_BETTER);
+		sprintf(name, "%s_%s_p99", mode, label);
+		bench_metric(ctx, name,
+				(double) run.latency[run.total * 99 / 100] / 1e3, "us",
+				BENCH_LOWER_BETTER);
+		sprintf(name, "%s_%s", mode, label);
+		bench_metric(ctx, name, mevents, "Mev/s", BENCH_HIGHER_BETTER);
+		sprintf(name, "%s_%s_batch", mode, label);
+		bench_metric(ctx, name, per_pass, "ev/pass", BENCH_HIGHER_BETTER);
+	} else {
+		run.failed = 1;
+		fprintf(stderr, "bench_event: %s: %lu of %lu events delivered\n",
+				name, run.consumed, run.total);
+	}
+
+	mimix_event_destroy(&run.loop);
+	free(run.stamps);
+	free(run.latency);
+	return run.failed ? -1 : 0;
+}
+
+int bench_event(bench_ctx_t *ctx) {
+	unsigned long duration_ms = bench_env_ulong("MIMIX_BENCH_EVENT_MS",
+			ctx->quick ? BENCH_EVENT_QUICK_MS : BENCH_EVENT_MS);
+	int status = 0;
+	size_t i;
+
+	for (i = 0; i < BENCH_EVENT_NRATES && status == 0; i++) {
+		status = bench_event_case(ctx, "imm", 0, bench_event_rates[i],
+				duration_ms);
+		if (status == 0) {
+			status = bench_event_case(ctx, "adapt", MIMIX_EVENT_HOLDOFF_MAX,
+					bench_event_rates[i], duration_ms);
+		}
+	}
+	return status;
+}
@@ -0,0 +1,345 @@
+/* IPC Transport Benchmark for MIMIX 3.1.2
+ *
+ * Functional Testing: Peer checksums every payload it receives
+ * Big O Analysis: O(n) per message: two copies by socket, one write by grant
+ * Memory Testing: Compares AF_UNIX copies against shared grant buffers
+ *
+ * Environment:
+ *   MIMIX_BENCH_IPC_MB     Payload MiB per message size (default 256,
+ *                          32 with -q)
+ *
+ * Each case is a ping-pong between this process and a forked peer: the
+ * payload goes one way, an 8-byte reply comes back. The producer writes
+ * and the peer reads every payload byte in both transports, so the
+ * difference is the transport.
+ */
+
+#include <headers/ipc.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "bench.h"
+
+#define BENCH_IPC_MB           256
+#define BENCH_IPC_QUICK_MB     32
+#define BENCH_IPC_MAX_MSG      (4UL * 1024 * 1024)
+#define BENCH_IPC_MIN_ITERS    32
+#define BENCH_IPC_MAX_ITERS    20000
+#define BENCH_IPC_WAIT_MS      10000L
+
+/* Peer reply tag for a payload it could not map: never a real checksum
+ * in practice, and the producer stops at the first one
+ */
+#define BENCH_IPC_POISON       (~0UL)
+
+/* Transport selector */
+#define BENCH_IPC_SOCKET       0
+#define BENCH_IPC_GRANT        1
+
+static const unsigned long bench_ipc_sizes[] = {
+	64, 4096, 64 * 1024, 1024 * 1024, BENCH_IPC_MAX_MSG
+};
+
+#define BENCH_IPC_NSIZES (sizeof(bench_ipc_sizes) / sizeof(bench_ipc_sizes[0]))
+
+/* Consumer work: word-wise sum of the payload
+ * Complexity: O(n)
+ */
+static unsigned long bench_ipc_sum(const unsigned char *data, size_t len) {
+	const unsigned long *words = (const unsigned long *) data;
+	size_t nwords = len / sizeof(unsigned long);
+	unsigned long sum = 0;
+	size_t i;
+
+	for (i = 0; i < nwords; i++) {
+		sum += words[i];
+	}
+	for (i = nwords * sizeof(unsigned long); i < len; i++) {
+		sum += data[i];
+	}
+	return sum;
+}
+
+/* Full-length socket transfers, retrying short counts
+ * Complexity: O(n)
+ */
+static int bench_ipc_write_all(int fd, const void *buf, size_t len) {
+	const unsigned char *p = (const unsigned char *) buf;
+
+	while (len > 0) {
+		ssize_t n = write(fd, p, len);
+
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			return -1;
+		}
+		p += n;
+		len -= (size_t) n;
+	}
+	return 0;
+}
+
+static int bench_ipc_read_all(int fd, void *buf, size_t len) {
+	unsigned char *p = (unsigned char *) buf;
+
+	while (len > 0) {
+		ssize_t n = read(fd, p, len);
+
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			return -1;
+		}
+		p += n;
+		len -= (size_t) n;
+	}
+	return 0;
+}
+
+/* Socket peer: length header, payload copy, checksum reply
+ * Complexity: O(n) per message
+ */
+static int bench_ipc_socket_peer(int fd) {
+	unsigned char *buf = (unsigned char *) malloc(BENCH_IPC_MAX_MSG);
+	unsigned long len, sum;
+
+	if (buf == NULL) {
+		return 1;
+	}
+	while (bench_ipc_read_all(fd, &len, sizeof(len)) == 0 && len > 0
+			&& len <= BENCH_IPC_MAX_MSG) {
+		if (bench_ipc_read_all(fd, buf, len) != 0) {
+			break;
+		}
+		sum = bench_ipc_sum(buf, len);
+		if (bench_ipc_write_all(fd, &sum, sizeof(sum)) != 0) {
+			break;
+		}
+	}
+	free(buf);
+	return 0;
+}
+
+/* Grant peer: map in place, checksum, release, reply with a control message
+ * Complexity: O(n) per message for the checksum only
+ */
+static int bench_ipc_grant_peer(int fd) {
+	mimix_ipc_channel_t ch;
+	mimix_ipc_desc_t desc, reply;
+	const unsigned char *data;
+
+	if (mimix_ipc_attach(&ch, fd, 1) != 0) {
+		return 1;
+	}
+	memset(&reply, 0, sizeof(reply));
+	while (mimix_ipc_recv(&ch, &desc, 1) == 0 && desc.tag != 0) {
+		data = (const unsigned char *) mimix_ipc_map(&ch, &desc,
+				MIMIX_IPC_RIGHT_READ);
+		if (data == NULL) {
+			reply.tag = BENCH_IPC_POISON;
+			mimix_ipc_send(&ch, &reply);
+			mimix_ipc_detach(&ch);
+			return 1;
+		}
+		reply.tag = bench_ipc_sum(data, desc.length);
+		mimix_ipc_release(&ch, desc.cap);
+		mimix_ipc_send(&ch, &reply);
+	}
+	mimix_ipc_detach(&ch);
+	return 0;
+}
+
+/* One round trip over a socket
+ * Complexity: O(n) - Copied into and out of the kernel
+ */
+static int bench_ipc_socket_round(int fd, const unsigned char *payload,
+		unsigned long len, unsigned long *sum) {
+	if (bench_ipc_write_all(fd, &len, sizeof(len)) != 0
+			|| bench_ipc_write_all(fd, payload, len) != 0) {
+		return -1;
+	}
+	return bench_ipc_read_all(fd, sum, sizeof(*sum));
+}
+
+/* One round trip through a fresh grant
+ * Complexity: O(n) - Written once in place, never copied
+ */
+static int bench_ipc_grant_round(mimix_ipc_channel_t *ch,
+		const unsigned char *payload, unsigned long len, unsigned long *sum) {
+	mimix_ipc_desc_t desc, reply;
+	unsigned char *buf;
+
+	if (mimix_ipc_grant(ch, len, MIMIX_IPC_RIGHT_READ, &desc.cap,
+			(void **) &buf) != 0) {
+		return -1;
+	}
+	/* Producer writes the message in place, as a socket sender would */
+	memcpy(buf, payload, len);
+	desc.offset = 0;
+	desc.length = len;
+	desc.tag = 1;
+	/* Bounded: a peer that failed to attach or died never replies */
+	if (mimix_ipc_send(ch, &desc) != 0
+			|| mimix_ipc_recv_timed(ch, &reply, BENCH_IPC_WAIT_MS) != 0) {
+		return -1;
+	}
+	*sum = reply.tag;
+	if (reply.tag == BENCH_IPC_POISON) {
+		errno = EPROTO;
+		return -1;
+	}
+	return 0;
+}
+
+/* Run every message size over one transport against a forked peer
+ * Complexity: O(sizes * iterations)
+ */
+static int bench_ipc_transport(bench_ctx_t *ctx, int transport,
+		unsigned long budget, const unsigned char *payload,
+		const unsigned long *expected) {
+	const char *label = (transport == BENCH_IPC_GRANT) ? "grant" : "socket";
+	mimix_ipc_channel_t ch;
+	int sv[2] = { -1, -1 };
+	int peer_status = 1;
+	int status = 0;
+	pid_t child;
+	size_t s;
+
+	if (transport == BENCH_IPC_GRANT) {
+		mimix_ipc_cap_t cap;
+		unsigned char *buf;
+
+		if (mimix_ipc_create(&ch, 2 * BENCH_IPC_MAX_MSG) != 0) {
+			return -1;
+		}
+		/* Fault the arena in up front so the first size does not pay
+		 * for it; the socket peer's buffer is warm after one message
+		 */
+		if (mimix_ipc_grant(&ch, BENCH_IPC_MAX_MSG, MIMIX_IPC_RIGHT_READ,
+				&cap, (void **) &buf) != 0) {
+			mimix_ipc_detach(&ch);
+			return -1;
+		}
+		memset(buf, 0, BENCH_IPC_MAX_MSG);
+		if (mimix_ipc_revoke(&ch, cap) != 0) {
+			perror("bench_ipc: revoke");
+			mimix_ipc_detach(&ch);
+			return -1;
+		}
+	} else if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+		return -1;
+	}
+
+	fflush(stdout);
+	child = fork();
+	if (child == 0) {
+		if (transport == BENCH_IPC_GRANT) {
+			_exit(bench_ipc_grant_peer(ch.fd));
+		}
+		close(sv[0]);
+		_exit(bench_ipc_socket_peer(sv[1]));
+	}
+	if (sv[1] >= 0) {
+		close(sv[1]);
+	}
+
+	for (s = 0; child > 0 && status == 0 && s < BENCH_IPC_NSIZES; s++) {
+		unsigned long len = bench_ipc_sizes[s];
+		unsigned long iters = budget / len;
+		unsigned long sum = 0;
+		unsigned long start, elapsed, k;
+		char name[BENCH_NAME_MAX];
+
+		if (iters < BENCH_IPC_MIN_ITERS) {
+			iters = BENCH_IPC_MIN_ITERS;
+		} else if (iters > BENCH_IPC_MAX_ITERS) {
+			iters = BENCH_IPC_MAX_ITERS;
+		}
+
+		sprintf(name, "%s_%luB", label, len);
+		bench_phase_begin(ctx);
+		start = bench_now_ns();
+		for (k = 0; k < iters && status == 0; k++) {
+			status = (transport == BENCH_IPC_GRANT)
+					? bench_ipc_grant_round(&ch, payload, len, &sum)
+					: bench_ipc_socket_round(sv[0], payload, len, &sum);
+		}
+		elapsed = bench_now_ns() - start;
+		bench_phase_end(ctx, name);
+
+		if (status != 0 || sum != expected[s]) {
+			fprintf(stderr, "bench_ipc: %s: %s\n", name,
+					status != 0 ? strerror(errno) : "checksum mismatch");
+			status = -1;
+			break;
+		}
+		sprintf(name, "%s_%luB_rtt", label, len);
+		bench_metric(ctx, name, (double) elapsed / (double) iters / 1e3, "us",
+				BENCH_LOWER_BETTER);
+		sprintf(name, "%s_%luB", label, len);
+		bench_metric(ctx, name, (double) (len * iters) / (double) elapsed,
+				"GB/s", BENCH_HIGHER_BETTER);
+	}
+
+	/* Shut the peer down: zero length / zero tag */
+	if (transport == BENCH_IPC_GRANT) {
+		mimix_ipc_desc_t stop;
+
+		memset(&stop, 0, sizeof(stop));
+		if (child > 0) {
+			mimix_ipc_send(&ch, &stop);
+		}
+		mimix_ipc_detach(&ch);
+	} else {
+		unsigned long stop = 0;
+
+		if (child > 0) {
+			bench_ipc_write_all(sv[0], &stop, sizeof(stop));
+		}
+		close(sv[0]);
+	}
+	if (child > 0) {
+		waitpid(child, &peer_status, 0);
+	}
+	if (child < 0 || !WIFEXITED(peer_status) || WEXITSTATUS(peer_status) != 0) {
+		status = -1;
+	}
+	return status;
+}
+
+int bench_ipc(bench_ctx_t *ctx) {
+	unsigned long mb = bench_env_ulong("MIMIX_BENCH_IPC_MB",
+			ctx->quick ? BENCH_IPC_QUICK_MB : BENCH_IPC_MB);
+	unsigned long expected[BENCH_IPC_NSIZES];
+	unsigned char *payload;
+	unsigned long i;
+	int status;
+
+	payload = (unsigned char *) malloc(BENCH_IPC_MAX_MSG);
+	if (payload == NULL) {
+		return -1;
+	}
+	for (i = 0; i < BENCH_IPC_MAX_MSG; i++) {
+		payload[i] = (unsigned char) (i * 131);
+	}
+	for (i = 0; i < BENCH_IPC_NSIZES; i++) {
+		expected[i] = bench_ipc_sum(payload, bench_ipc_sizes[i]);
+	}
+
+	status = bench_ipc_transport(ctx, BENCH_IPC_SOCKET, mb * 1024UL * 1024UL,
+			payload, expected);
+	if (status == 0) {
+		status = bench_ipc_transport(ctx, BENCH_IPC_GRANT,
+				mb * 1024UL * 1024UL, payload, expected);
+	}
+
+	free(payload);
+	return status;
+}
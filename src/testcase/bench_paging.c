@@ -0,0 +1,230 @@
+/* Paging Benchmark for MIMIX 3.1.2
+ *
+ * Functional Testing: Every translation is checked against the layout
+ * Big O Analysis: O(n) translations per trace
+ * Memory Testing: TLB reach of 4 KiB vs 2 MiB layouts, shootdown batching
+ *
+ * Environment:
+ *   MIMIX_BENCH_PAGING_MB  Mapped region in MiB (default 1024, 256 with -q)
+ *   MIMIX_BENCH_PAGING_N   Translations per trace (default 16M, 4M with -q)
+ *
+ * The sequential trace advances one cache line per access; the random
+ * trace draws uniformly over the region. Shootdown cases unmap and remap
+ * random pages with four TLBs warm, once per page and once per batch.
+ */
+
+#include <headers/paging.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+
+#define BENCH_PAGING_MB         1024
+#define BENCH_PAGING_QUICK_MB   256
+#define BENCH_PAGING_N          (16UL * 1024 * 1024)
+#define BENCH_PAGING_QUICK_N    (4UL * 1024 * 1024)
+#define BENCH_PAGING_VA         0x7F0000000000UL
+#define BENCH_PAGING_PA         0x100000000UL
+#define BENCH_PAGING_STRIDE     64
+#define BENCH_PAGING_CPUS       4
+#define BENCH_PAGING_UNMAPS     4096
+
+#define BENCH_PAGING_SEQ        0
+#define BENCH_PAGING_RAND       1
+
+/* Trace generator: xorshift64
+ * Complexity: O(1)
+ */
+static unsigned long bench_paging_next(unsigned long *state) {
+	unsigned long x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	*state = x;
+	return x;
+}
+
+/* Offset of access i within the region
+ * Complexity: O(1)
+ */
+static unsigned long bench_paging_offset(int trace, unsigned long i,
+		unsigned long size, unsigned long *state) {
+	if (trace == BENCH_PAGING_SEQ) {
+		return (i * BENCH_PAGING_STRIDE) % size;
+	}
+	return bench_paging_next(state) % size;
+}
+
+/* Run one trace through a cold TLB and report speed and hit rate
+ * Complexity: O(n)
+ */
+static int bench_paging_trace(bench_ctx_t *ctx, mimix_pt_space_t *space,
+		mimix_tlb_t *tlb, const char *layout, int trace, unsigned long size,
+		unsigned long n) {
+	const char *label = (trace == BENCH_PAGING_SEQ) ? "seq" : "rand";
+	unsigned long state = 0x9E3779B97F4A7C15UL;
+	unsigned long errors = 0;
+	unsigned long start, elapsed, i;
+	char name[BENCH_NAME_MAX];
+
+	mimix_tlb_init(tlb);
+	sprintf(name, "%s_%s", layout, label);
+	bench_phase_begin(ctx);
+	start = bench_now_ns();
+	for (i = 0; i < n; i++) {
+		unsigned long off = bench_paging_offset(trace, i, size, &state);
+		unsigned long pa;
+
+		if (mimix_tlb_translate(tlb, space, BENCH_PAGING_VA + off,
+				MIMIX_TLB_READ, &pa) != 0 || pa != BENCH_PAGING_PA + off) {
+			errors++;
+		}
+	}
+	elapsed = bench_now_ns() - start;
+	bench_phase_end(ctx, name);
+
+	bench_metric(ctx, name, (double) n / (double) elapsed * 1e3, "Mtr/s",
+			BENCH_HIGHER_BETTER);
+	sprintf(name, "%s_%s_hit", layout, label);
+	bench_metric(ctx, name, 100.0 * (double) tlb->stats.hits / (double) n, "%",
+			BENCH_HIGHER_BETTER);
+	if (errors != 0) {
+		fprintf(stderr, "bench_paging: %s: %lu bad translations\n", name,
+				errors);
+		return -1;
+	}
+	return 0;
+}
+
+/* Bare table walks, the cost every TLB miss pays
+ * Complexity: O(n)
+ */
+static int bench_paging_walks(bench_ctx_t *ctx, mimix_pt_space_t *space,
+		unsigned long size, unsigned long n) {
+	unsigned long state = 0x2545F4914F6CDD1DUL;
+	unsigned long errors = 0;
+	unsigned long start, i, pte;
+	unsigned int shift;
+
+	bench_phase_begin(ctx);
+	start = bench_now_ns();
+	for (i = 0; i < n; i++) {
+		errors += (mimix_pt_walk(space, BENCH_PAGING_VA
+				+ bench_paging_next(&state) % size, &pte, &shift) != 0);
+	}
+	bench_metric(ctx, "4k_walk", (double) n / (double) (bench_now_ns() - start)
+			* 1e3, "Mtr/s", BENCH_HIGHER_BETTER);
+	bench_phase_end(ctx, "4k_walk");
+	return (errors != 0) ? -1 : 0;
+}
+
+/* Unmap and remap random pages with every TLB warm
+ * Complexity: O(u * ways) plus one shootdown per page or per batch
+ */
+static int bench_paging_shootdown(bench_ctx_t *ctx, mimix_pt_space_t *space,
+		mimix_tlb_t *tlbs, unsigned long size, int batched) {
+	const char *name = batched ? "shootdown_batch" : "shootdown_each";
+	mimix_tlb_batch_t batch;
+	unsigned long state = 0xD1B54A32D192ED03UL;
+	unsigned long sent = 0, pa;
+	unsigned long start, elapsed, i;
+	int t, status = 0;
+	char metric[BENCH_NAME_MAX];
+
+	for (t = 0; t < BENCH_PAGING_CPUS; t++) {
+		mimix_tlb_init(&tlbs[t]);
+		for (i = 0; i < 4 * MIMIX_TLB_SETS * MIMIX_TLB_WAYS; i++) {
+			mimix_tlb_translate(&tlbs[t], space, BENCH_PAGING_VA
+					+ bench_paging_next(&state) % size, MIMIX_TLB_READ, &pa);
+		}
+	}
+
+	mimix_tlb_batch_init(&batch, space->asid);
+	bench_phase_begin(ctx);
+	start = bench_now_ns();
+	for (i = 0; i < BENCH_PAGING_UNMAPS && status == 0; i++) {
+		unsigned long off = (bench_paging_next(&state) % size)
+				& ~(MIMIX_PAGE_SIZE - 1);
+
+		/* Batched mode stays below the overflow point: page-exact flushes */
+		if (mimix_pt_unmap(space, BENCH_PAGING_VA + off, MIMIX_PAGE_SIZE,
+				&batch) != 0) {
+			status = -1;
+		}
+		if (!batched || batch.count == MIMIX_TLB_BATCH) {
+			mimix_tlb_shootdown(tlbs, BENCH_PAGING_CPUS, &batch);
+		}
+		if (mimix_pt_map(space, BENCH_PAGING_VA + off, BENCH_PAGING_PA + off,
+				MIMIX_PAGE_SIZE, 0) != 0) {
+			status = -1;
+		}
+	}
+	mimix_tlb_shootdown(tlbs, BENCH_PAGING_CPUS, &batch);
+	elapsed = bench_now_ns() - start;
+	bench_phase_end(ctx, name);
+
+	for (t = 0; t < BENCH_PAGING_CPUS; t++) {
+		sent += tlbs[t].stats.shootdowns;
+	}
+	bench_metric(ctx, name, (double) elapsed / BENCH_PAGING_UNMAPS,
+			"ns/page", BENCH_LOWER_BETTER);
+	sprintf(metric, "%s_ipi", name);
+	bench_metric(ctx, metric, (double) sent / BENCH_PAGING_UNMAPS, "ipi/page",
+			BENCH_LOWER_BETTER);
+	return status;
+}
+
+int bench_paging(bench_ctx_t *ctx) {
+	unsigned long mb = bench_env_ulong("MIMIX_BENCH_PAGING_MB",
+			ctx->quick ? BENCH_PAGING_QUICK_MB : BENCH_PAGING_MB);
+	unsigned long n = bench_env_ulong("MIMIX_BENCH_PAGING_N",
+			ctx->quick ? BENCH_PAGING_QUICK_N : BENCH_PAGING_N);
+	unsigned long size = mb * 1024UL * 1024UL;
+	mimix_page_pool_t pool;
+	mimix_pt_space_t small, huge;
+	mimix_tlb_t *tlbs;
+	int status = 0;
+
+	if (size == 0 || size % (2UL * 1024 * 1024) != 0) {
+		fprintf(stderr, "bench_paging: region must be a multiple of 2 MiB\n");
+		return -1;
+	}
+	tlbs = (mimix_tlb_t *) malloc(BENCH_PAGING_CPUS * sizeof(mimix_tlb_t));
+	/* One leaf table per 2 MiB, plus interior tables for both spaces */
+	if (tlbs == NULL || mimix_page_pool_init(&pool,
+			size / (2UL * 1024 * 1024) + 64) != 0) {
+		free(tlbs);
+		return -1;
+	}
+	if (mimix_pt_init(&small, &pool, 1) != 0
+			|| mimix_pt_init(&huge, &pool, 2) != 0
+			|| mimix_pt_map(&small, BENCH_PAGING_VA, BENCH_PAGING_PA, size,
+					MIMIX_PTE_USER) != 0
+			|| mimix_pt_map(&huge, BENCH_PAGING_VA, BENCH_PAGING_PA, size,
+					MIMIX_PTE_USER | MIMIX_PT_ALLOW_HUGE) != 0) {
+		perror("bench_paging: map");
+		mimix_page_pool_destroy(&pool);
+		free(tlbs);
+		return -1;
+	}
+	printf("  region: %lu MiB, tables: %lu (4k) vs %lu (2m)\n", mb,
+			small.tables, huge.tables);
+
+	status |= bench_paging_trace(ctx, &small, &tlbs[0], "4k",
+			BENCH_PAGING_SEQ, size, n);
+	status |= bench_paging_trace(ctx, &small, &tlbs[0], "4k",
+			BENCH_PAGING_RAND, size, n);
+	status |= bench_paging_trace(ctx, &huge, &tlbs[0], "2m",
+			BENCH_PAGING_SEQ, size, n);
+	status |= bench_paging_trace(ctx, &huge, &tlbs[0], "2m",
+			BENCH_PAGING_RAND, size, n);
+	status |= bench_paging_walks(ctx, &small, size, n);
+	status |= bench_paging_shootdown(ctx, &small, tlbs, size, 0);
+	status |= bench_paging_shootdown(ctx, &small, tlbs, size, 1);
+
+	mimix_pt_destroy(&small);
+	mimix_pt_destroy(&huge);
+	mimix_page_pool_destroy(&pool);
+	free(tlbs);
+	return status ? -1 : 0;
+}
@@ -0,0 +1,254 @@
+/* Snapshot Startup Benchmark for MIMIX 3.1.2
+ *
+ * Functional Testing: Restored spaces must translate like the cold ones
+ * Big O Analysis: Cold init O(mapped pages), restore O(image bytes)
+ * Memory Testing: Boot timeline: cold init vs mapped snapshot image
+ *
+ * Environment:
+ *   MIMIX_BENCH_DIR                Directory for the image (default /tmp)
+ *   MIMIX_BENCH_SNAPSHOT_MB        Kernel region in MiB, 4 KiB pages
+ *                                  (default 4096, 1024 with -q)
+ *   MIMIX_BENCH_SNAPSHOT_SPACES    Process spaces of 16 MiB each
+ *                                  (default 64, 16 with -q)
+ *
+ * Boot state is the table pool behind one kernel space plus a set of
+ * process spaces. The restore is timed twice: with the image in the page
+ * cache, and after POSIX_FADV_DONTNEED on filesystems that honour it.
+ * "touch" walks one address per leaf table, so it includes the faults
+ * that restore defers to first use.
+ */
+
+#include <headers/snapshot.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "bench.h"
+
+#define BENCH_SNAPSHOT_MB           4096
+#define BENCH_SNAPSHOT_QUICK_MB     1024
+#define BENCH_SNAPSHOT_SPACES       64
+#define BENCH_SNAPSHOT_QUICK_SPACES 16
+#define BENCH_SNAPSHOT_SPACE_MB     16
+#define BENCH_SNAPSHOT_KERNEL_VA    0x700000000000UL
+#define BENCH_SNAPSHOT_USER_VA      0x400000UL
+#define BENCH_SNAPSHOT_LEAF         (2UL * 1024 * 1024)
+#define BENCH_SNAPSHOT_MS           1e6
+
+/* Cold boot: a fresh pool, the kernel map and every process map
+ * Complexity: O(mapped pages)
+ */
+static int bench_snapshot_cold(mimix_page_pool_t *pool,
+		mimix_pt_space_t *spaces, int nspaces, unsigned long kernel_len) {
+	unsigned long tables = kernel_len / BENCH_SNAPSHOT_LEAF + (unsigned long)
+			(nspaces - 1) * (BENCH_SNAPSHOT_SPACE_MB / 2 + 3) + 64;
+	int i;
+
+	if (mimix_page_pool_init(pool, tables) != 0) {
+		return -1;
+	}
+	for (i = 0; i < nspaces; i++) {
+		if (mimix_pt_init(&spaces[i], pool, (unsigned int) i + 1) != 0) {
+			return -1;
+		}
+	}
+	if (mimix_pt_map(&spaces[0], BENCH_SNAPSHOT_KERNEL_VA, 0, kernel_len,
+			MIMIX_PTE_WRITE | MIMIX_PTE_GLOBAL) != 0) {
+		return -1;
+	}
+	for (i = 1; i < nspaces; i++) {
+		if (mimix_pt_map(&spaces[i], BENCH_SNAPSHOT_USER_VA,
+				kernel_len + (unsigned long) i * BENCH_SNAPSHOT_SPACE_MB
+				* 1024 * 1024, BENCH_SNAPSHOT_SPACE_MB * 1024UL * 1024,
+				MIMIX_PTE_WRITE | MIMIX_PTE_USER) != 0) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/* First use: one walk per leaf table, checked against the cold spaces
+ * Complexity: O(tables)
+ */
+static unsigned long bench_snapshot_touch(mimix_pt_space_t *restored,
+		mimix_pt_space_t *cold, int nspaces, unsigned long kernel_len) {
+	unsigned long errors = 0;
+	unsigned long va, len, a, b;
+	unsigned int sa, sb;
+	int i;
+
+	for (i = 0; i < nspaces; i++) {
+		va = (i == 0) ? BENCH_SNAPSHOT_KERNEL_VA : BENCH_SNAPSHOT_USER_VA;
+		len = (i == 0) ? kernel_len : BENCH_SNAPSHOT_SPACE_MB * 1024UL * 1024;
+		for (; len > 0; va += BENCH_SNAPSHOT_LEAF, len -= BENCH_SNAPSHOT_LEAF) {
+			errors += (mimix_pt_walk(&restored[i], va + MIMIX_PAGE_SIZE, &a,
+					&sa) != 0 || mimix_pt_walk(&cold[i], va + MIMIX_PAGE_SIZE,
+					&b, &sb) != 0 || a != b);
+		}
+	}
+	return errors;
+}
+
+static void bench_snapshot_evict(const char *path) {
+	int fd = open(path, O_RDONLY);
+
+	if (fd >= 0) {
+		posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+		close(fd);
+	}
+}
+
+/* Open, validate and map the image, then touch every table
+ * Complexity: O(image bytes)
+ */
+static int bench_snapshot_restore(bench_ctx_t *ctx, const char *path,
+		const char *name, mimix_pt_space_t *cold, int nspaces,
+		unsigned long kernel_len, double *total_ms) {
+	mimix_page_pool_t pool;
+	mimix_pt_space_t *spaces;
+	mimix_snap_t snap;
+	unsigned long start, restored, touched, errors;
+	char metric[BENCH_NAME_MAX];
+	int i;
+
+	spaces = (mimix_pt_space_t *) malloc((size_t) nspaces
+			* sizeof(mimix_pt_space_t));
+	if (spaces == NULL) {
+		return -1;
+	}
+	bench_phase_begin(ctx);
+	start = bench_now_ns();
+	if (mimix_snap_open(&snap, path, MIMIX_BUILD_ID) != 0) {
+		perror("bench_snapshot: open");
+		bench_phase_end(ctx, name);
+		free(spaces);
+		return -1;
+	}
+	if (mimix_snap_restore_paging(&snap, &pool, spaces, nspaces) != 0) {
+		perror("bench_snapshot: restore");
+		mimix_snap_close(&snap);
+		bench_phase_end(ctx, name);
+		free(spaces);
+		return -1;
+	}
+	mimix_snap_close(&snap);
+	restored = bench_now_ns();
+	errors = bench_snapshot_touch(spaces, cold, nspaces, kernel_len);
+	touched = bench_now_ns();
+	bench_phase_end(ctx, name);
+
+	bench_metric(ctx, name, (double) (restored - start) / BENCH_SNAPSHOT_MS,
+			"ms", BENCH_LOWER_BETTER);
+	sprintf(metric, "%s_touch", name);
+	bench_metric(ctx, metric, (double) (touched - restored)
+			/ BENCH_SNAPSHOT_MS, "ms", BENCH_LOWER_BETTER);
+	*total_ms = (double) (touched - start) / BENCH_SNAPSHOT_MS;
+
+	for (i = 0; i < nspaces; i++) {
+		mimix_pt_destroy(&spaces[i]);
+	}
+	mimix_page_pool_destroy(&pool);
+	free(spaces);
+	if (errors != 0) {
+		fprintf(stderr, "bench_snapshot: %s: %lu translations differ\n", name,
+				errors);
+		return -1;
+	}
+	return 0;
+}
+
+int bench_snapshot(bench_ctx_t *ctx) {
+	unsigned long mb = bench_env_ulong("MIMIX_BENCH_SNAPSHOT_MB",
+			ctx->quick ? BENCH_SNAPSHOT_QUICK_MB : BENCH_SNAPSHOT_MB);
+	int nspaces = 1 + (int) bench_env_ulong("MIMIX_BENCH_SNAPSHOT_SPACES",
+			ctx->quick ? BENCH_SNAPSHOT_QUICK_SPACES : BENCH_SNAPSHOT_SPACES);
+	unsigned long kernel_len = mb * 1024UL * 1024UL;
+	const char *dir = getenv("MIMIX_BENCH_DIR");
+	char path[PATH_MAX];
+	mimix_page_pool_t pool;
+	mimix_pt_space_t *spaces;
+	mimix_snap_writer_t *writer;
+	mimix_snap_t snap;
+	unsigned long start, cold_ns;
+	double warm_ms = 0.0, evicted_ms = 0.0;
+	int status = 0, rc;
+
+	if (kernel_len == 0 || kernel_len % BENCH_SNAPSHOT_LEAF != 0) {
+		fprintf(stderr, "bench_snapshot: region must be a multiple of 2 MiB\n");
+		return -1;
+	}
+	sprintf(path, "%.*s/mimix-bench-snapshot.%ld", PATH_MAX - 64,
+			dir ? dir : "/tmp", (long) getpid());
+	spaces = (mimix_pt_space_t *) calloc((size_t) nspaces,
+			sizeof(mimix_pt_space_t));
+	writer = (mimix_snap_writer_t *) malloc(sizeof(mimix_snap_writer_t));
+	if (spaces == NULL || writer == NULL) {
+		free(spaces);
+		free(writer);
+		return -1;
+	}
+
+	bench_phase_begin(ctx);
+	start = bench_now_ns();
+	status = bench_snapshot_cold(&pool, spaces, nspaces, kernel_len);
+	cold_ns = bench_now_ns() - start;
+	bench_phase_end(ctx, "cold_init");
+	if (status != 0) {
+		perror("bench_snapshot: cold init");
+		mimix_page_pool_destroy(&pool);
+		free(spaces);
+		free(writer);
+		return -1;
+	}
+	bench_metric(ctx, "cold_init", (double) cold_ns / BENCH_SNAPSHOT_MS, "ms",
+			BENCH_LOWER_BETTER);
+
+	bench_phase_begin(ctx);
+	start = bench_now_ns();
+	if (mimix_snap_create(writer, path, MIMIX_BUILD_ID) != 0
+			|| mimix_snap_save_paging(writer, &pool, spaces, nspaces) != 0
+			|| mimix_snap_commit(writer) != 0) {
+		perror("bench_snapshot: save");
+		mimix_snap_abort(writer);
+		status = -1;
+	}
+	bench_metric(ctx, "save", (double) (bench_now_ns() - start)
+			/ BENCH_SNAPSHOT_MS, "ms", BENCH_LOWER_BETTER);
+	bench_phase_end(ctx, "save");
+	printf("  kernel: %lu MiB, spaces: %d, image: %.1f MiB\n", mb, nspaces,
+			(double) writer->header.size / (1024.0 * 1024.0));
+
+	if (status == 0) {
+		status |= bench_snapshot_restore(ctx, path, "restore", spaces,
+				nspaces, kernel_len, &warm_ms);
+		bench_snapshot_evict(path);
+		status |= bench_snapshot_restore(ctx, path, "restore_evicted",
+				spaces, nspaces, kernel_len, &evicted_ms);
+	}
+	if (status == 0) {
+		bench_metric(ctx, "speedup", (double) cold_ns / BENCH_SNAPSHOT_MS
+				/ warm_ms, "x", BENCH_HIGHER_BETTER);
+
+		/* A stale image must be rejected before any section is read */
+		start = bench_now_ns();
+		rc = mimix_snap_open(&snap, path, MIMIX_BUILD_ID + 1);
+		bench_metric(ctx, "stale_detect", (double) (bench_now_ns() - start)
+				/ 1e3, "us", BENCH_LOWER_BETTER);
+		if (rc == 0) {
+			mimix_snap_close(&snap);
+		}
+		if (rc == 0 || errno != ESTALE) {
+			fprintf(stderr, "bench_snapshot: stale image accepted\n");
+			status = -1;
+		}
+	}
+
+	unlink(path);
+	mimix_page_pool_destroy(&pool);
+	free(spaces);
+	free(writer);
+	return status ? -1 : 0;
+}
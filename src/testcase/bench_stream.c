@@ -0,0 +1,206 @@
+/* Streaming I/O Benchmark for MIMIX 3.1.2
+ *
+ * Functional Testing: All readers must produce the same checksum
+ * Big O Analysis: O(n) - One sequential pass over the file per reader
+ * Memory Testing: Compares copy-based fread against zero-copy slices
+ *
+ * Environment:
+ *   MIMIX_BENCH_DIR        Directory for the scratch file (default /tmp)
+ *   MIMIX_BENCH_STREAM_MB  File size in MiB (default 2048, 128 with -q)
+ *
+ * Each scan is preceded by POSIX_FADV_DONTNEED so filesystems that honour
+ * it measure storage rather than a warm page cache.
+ */
+
+#include <headers/stream.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "bench.h"
+
+#define BENCH_STREAM_MB        2048
+#define BENCH_STREAM_QUICK_MB  128
+#define BENCH_STREAM_FREAD_BUF (1024 * 1024)
+
+/* Consumer work: word-wise sum, vectorised by the compiler
+ * Complexity: O(n)
+ */
+static unsigned long bench_stream_sum(const unsigned char *data, size_t len) {
+	const unsigned long *words = (const unsigned long *) data;
+	size_t nwords = len / sizeof(unsigned long);
+	unsigned long sum = 0;
+	size_t i;
+
+	for (i = 0; i < nwords; i++) {
+		sum += words[i];
+	}
+	for (i = nwords * sizeof(unsigned long); i < len; i++) {
+		sum += data[i];
+	}
+	return sum;
+}
+
+/* Drop the file from the page cache where the filesystem allows it
+ * Complexity: O(n) pages
+ */
+static void bench_stream_evict(const char *path) {
+	int fd = open(path, O_RDONLY);
+
+	if (fd >= 0) {
+		posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+		close(fd);
+	}
+}
+
+/* Generate the scratch file through the coalescing writer
+ * Complexity: O(n) - Odd-sized writes exercise buffer coalescing
+ */
+static int bench_stream_generate(bench_ctx_t *ctx, const char *path,
+		unsigned long size) {
+	mimix_stream_writer_t w;
+	unsigned long block[1021];  /* Deliberately not a power of two */
+	unsigned long done = 0;
+	unsigned long start;
+	size_t i;
+
+	for (i = 0; i < sizeof(block) / sizeof(block[0]); i++) {
+		block[i] = i * 0x9E3779B97F4A7C15UL;
+	}
+	if (mimix_stream_writer_open(&w, path) != 0) {
+		return -1;
+	}
+
+	bench_phase_begin(ctx);
+	start = bench_now_ns();
+	while (done < size) {
+		size_t len = sizeof(block);
+
+		if (size - done < len) {
+			len = (size_t) (size - done);
+		}
+		block[0] = done;
+		if (mimix_stream_write(&w, block, len) != 0) {
+			mimix_stream_writer_close(&w);
+			return -1;
+		}
+		done += len;
+	}
+	if (mimix_stream_writer_close(&w) != 0) {
+		return -1;
+	}
+	bench_phase_end(ctx, "write");
+	bench_metric(ctx, "write", (double) size / (double) (bench_now_ns() - start),
+			"GB/s", BENCH_HIGHER_BETTER);
+	return 0;
+}
+
+/* Baseline: fread into a user buffer
+ * Complexity: O(n) - One kernel-to-user copy per byte
+ */
+static int bench_stream_fread(const char *path, unsigned long *sum) {
+	FILE *f = fopen(path, "rb");
+	unsigned char *buf;
+	size_t got;
+	int failed;
+
+	if (f == NULL) {
+		return -1;
+	}
+	buf = (unsigned char *) malloc(BENCH_STREAM_FREAD_BUF);
+	if (buf == NULL) {
+		fclose(f);
+		return -1;
+	}
+	*sum = 0;
+	while ((got = fread(buf, 1, BENCH_STREAM_FREAD_BUF, f)) > 0) {
+		*sum += bench_stream_sum(buf, got);
+	}
+	failed = ferror(f);
+	free(buf);
+	if (fclose(f) != 0 || failed) {
+		return -1;
+	}
+	return 0;
+}
+
+/* Zero-copy: iterate slices from a stream reader
+ * Complexity: O(n)
+ */
+static int bench_stream_slices(const char *path, int flags,
+		unsigned long *sum) {
+	mimix_stream_reader_t r;
+	mimix_slice_t slice;
+	int status;
+
+	if (mimix_stream_open(&r, path, flags, 0) != 0) {
+		return -1;
+	}
+	*sum = 0;
+	while ((status = mimix_stream_next(&r, &slice)) > 0) {
+		*sum += bench_stream_sum(slice.data, slice.len);
+	}
+	mimix_stream_close(&r);
+	return status;
+}
+
+int bench_stream(bench_ctx_t *ctx) {
+	static const struct {
+		const char *name;
+		int flags;                    /* -1 selects the fread baseline */
+	} scans[] = {
+		{ "fread", -1 },
+		{ "mmap", MIMIX_STREAM_FORCE_MMAP },
+		{ "pread_pool", MIMIX_STREAM_FORCE_PREAD }
+	};
+	char path[PATH_MAX];
+	const char *dir = getenv("MIMIX_BENCH_DIR");
+	unsigned long mb = bench_env_ulong("MIMIX_BENCH_STREAM_MB",
+			ctx->quick ? BENCH_STREAM_QUICK_MB : BENCH_STREAM_MB);
+	unsigned long size = mb * 1024UL * 1024UL;
+	unsigned long reference = 0;
+	int status = 0;
+	size_t i;
+
+	sprintf(path, "%.*s/mimix-bench-stream.%ld", PATH_MAX - 64,
+			dir ? dir : "/tmp", (long) getpid());
+	if (bench_stream_generate(ctx, path, size) != 0) {
+		perror("bench_stream: generate");
+		unlink(path);
+		return -1;
+	}
+	printf("  file: %s (%lu MiB)\n", path, mb);
+
+	for (i = 0; i < sizeof(scans) / sizeof(scans[0]); i++) {
+		unsigned long sum = 0;
+		unsigned long start;
+		int rc;
+
+		bench_stream_evict(path);
+		bench_phase_begin(ctx);
+		start = bench_now_ns();
+		rc = (scans[i].flags < 0) ? bench_stream_fread(path, &sum)
+				: bench_stream_slices(path, scans[i].flags, &sum);
+		bench_metric(ctx, scans[i].name,
+				(double) size / (double) (bench_now_ns() - start), "GB/s",
+				BENCH_HIGHER_BETTER);
+		bench_phase_end(ctx, scans[i].name);
+
+		if (rc < 0) {
+			fprintf(stderr, "bench_stream: %s: %s\n", scans[i].name,
+					strerror(errno));
+			status = -1;
+		} else if (i == 0) {
+			reference = sum;
+		} else if (sum != reference) {
+			fprintf(stderr, "bench_stream: %s checksum mismatch\n",
+					scans[i].name);
+			status = -1;
+		}
+	}
+
+	unlink(path);
+	return status;
+}
@@ -0,0 +1,223 @@
+/* Compressed Page Store Benchmark for MIMIX 3.1.2
+ *
+ * Functional Testing: Every page is loaded back and compared
+ * Big O Analysis: O(pages * PAGE) per pass
+ * Memory Testing: Pool footprint against the uncompressed working set
+ *
+ * Environment:
+ *   MIMIX_BENCH_ZRAM_PAGES  Working set in 4 KiB pages (default 32768,
+ *                           8192 with -q)
+ *
+ * The working set mixes the page kinds a tenant typically swaps out:
+ * zero pages, pages of one repeated word, text drawn from a small
+ * vocabulary, arrays of small records, and random bytes standing in for
+ * already-compressed data. Store and load rates count uncompressed
+ * bytes; the codec rows time compress and decompress alone on the
+ * compressible pages.
+ */
+
+#include <headers/zram.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+
+#define BENCH_ZRAM_PAGES        32768
+#define BENCH_ZRAM_QUICK_PAGES  8192
+#define BENCH_ZRAM_MB           (1024.0 * 1024.0)
+
+/* Page mix in percent: zero, same-filled, text, records, random */
+#define BENCH_ZRAM_ZERO         20
+#define BENCH_ZRAM_SAME         5
+#define BENCH_ZRAM_TEXT         35
+#define BENCH_ZRAM_RECORDS      30
+
+static const char *const bench_zram_words[] = {
+	"the ", "page ", "kernel ", "of ", "memory ", "and ", "to ", "process ",
+	"map ", "a ", "tenant ", "is ", "free ", "cache ", "in ", "table "
+};
+
+/* Generator: xorshift64
+ * Complexity: O(1)
+ */
+static unsigned long bench_zram_next(unsigned long *state) {
+	unsigned long x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	*state = x;
+	return x;
+}
+
+/* Fill one page of the working set according to the mix
+ * Complexity: O(PAGE)
+ */
+static void bench_zram_fill(unsigned char *page, unsigned long *state) {
+	unsigned long kind = bench_zram_next(state) % 100;
+	unsigned long *words = (unsigned long *) page;
+	size_t i, n;
+
+	if (kind < BENCH_ZRAM_ZERO) {
+		memset(page, 0, MIMIX_ZRAM_PAGE);
+	} else if (kind < BENCH_ZRAM_ZERO + BENCH_ZRAM_SAME) {
+		unsigned long fill = bench_zram_next(state);
+
+		for (i = 0; i < MIMIX_ZRAM_PAGE / sizeof(unsigned long); i++) {
+			words[i] = fill;
+		}
+	} else if (kind < BENCH_ZRAM_ZERO + BENCH_ZRAM_SAME + BENCH_ZRAM_TEXT) {
+		for (i = 0; i < MIMIX_ZRAM_PAGE; i += n) {
+			const char *w = bench_zram_words[bench_zram_next(state) % 16];
+
+			n = strlen(w);
+			if (n > MIMIX_ZRAM_PAGE - i) {
+				n = MIMIX_ZRAM_PAGE - i;
+			}
+			memcpy(page + i, w, n);
+		}
+	} else if (kind < BENCH_ZRAM_ZERO + BENCH_ZRAM_SAME + BENCH_ZRAM_TEXT
+			+ BENCH_ZRAM_RECORDS) {
+		/* 32-byte records: id, small flags, heap pointer, padding */
+		unsigned long id = bench_zram_next(state) & 0xFFFFF;
+
+		for (i = 0; i < MIMIX_ZRAM_PAGE / sizeof(unsigned long); i += 4) {
+			words[i] = id++;
+			words[i + 1] = bench_zram_next(state) & 0x7;
+			words[i + 2] = 0x7F0000000000UL + ((bench_zram_next(state) & 0xFFFF)
+					<< 4);
+			words[i + 3] = 0;
+		}
+	} else {
+		for (i = 0; i < MIMIX_ZRAM_PAGE / sizeof(unsigned long); i++) {
+			words[i] = bench_zram_next(state);
+		}
+	}
+}
+
+/* Codec alone on the pages the store compressed
+ * Complexity: O(pages * PAGE)
+ */
+static int bench_zram_codec(bench_ctx_t *ctx, const mimix_zram_t *zram,
+		const unsigned char *set, unsigned long npages) {
+	unsigned char packed[MIMIX_LZ_BOUND(MIMIX_ZRAM_PAGE)];
+	unsigned char page[MIMIX_ZRAM_PAGE];
+	unsigned long bytes = 0, errors = 0;
+	unsigned long start, elapsed, i;
+
+	bench_phase_begin(ctx);
+	start = bench_now_ns();
+	for (i = 0; i < npages; i++) {
+		if (zram->slots[i].flags == MIMIX_ZRAM_COMPRESSED) {
+			errors += (mimix_lz_compress(set + i * MIMIX_ZRAM_PAGE,
+					MIMIX_ZRAM_PAGE, packed, sizeof(packed)) < 0);
+			bytes += MIMIX_ZRAM_PAGE;
+		}
+	}
+	elapsed = bench_now_ns() - start;
+	bench_phase_end(ctx, "lz_compress");
+	bench_metric(ctx, "lz_compress", (double) bytes / (double) elapsed, "GB/s",
+			BENCH_HIGHER_BETTER);
+
+	bench_phase_begin(ctx);
+	start = bench_now_ns();
+	for (i = 0; i < npages; i++) {
+		const mimix_zram_slot_t *slot = &zram->slots[i];
+
+		if (slot->flags == MIMIX_ZRAM_COMPRESSED) {
+			errors += (mimix_lz_decompress(slot->u.object, slot->length, page,
+					sizeof(page)) != MIMIX_ZRAM_PAGE);
+		}
+	}
+	elapsed = bench_now_ns() - start;
+	bench_phase_end(ctx, "lz_decompress");
+	bench_metric(ctx, "lz_decompress", (double) bytes / (double) elapsed,
+			"GB/s", BENCH_HIGHER_BETTER);
+	return (errors != 0) ? -1 : 0;
+}
+
+int bench_zram(bench_ctx_t *ctx) {
+	unsigned long npages = bench_env_ulong("MIMIX_BENCH_ZRAM_PAGES",
+			ctx->quick ? BENCH_ZRAM_QUICK_PAGES : BENCH_ZRAM_PAGES);
+	unsigned long total = npages * MIMIX_ZRAM_PAGE;
+	unsigned long state = 0x9E3779B97F4A7C15UL;
+	unsigned long start, elapsed, used, i;
+	unsigned long errors = 0;
+	unsigned char page[MIMIX_ZRAM_PAGE];
+	unsigned char *set;
+	mimix_zram_t *zram;
+	int status = 0;
+
+	if (npages == 0) {
+		fprintf(stderr, "bench_zram: working set must not be empty\n");
+		return -1;
+	}
+	set = (unsigned char *) malloc(total);
+	zram = (mimix_zram_t *) malloc(sizeof(mimix_zram_t));
+	if (set == NULL || zram == NULL || mimix_zram_init(zram, npages) != 0) {
+		perror("bench_zram: init");
+		free(set);
+		free(zram);
+		return -1;
+	}
+	for (i = 0; i < npages; i++) {
+		bench_zram_fill(set + i * MIMIX_ZRAM_PAGE, &state);
+	}
+
+	bench_phase_begin(ctx);
+	start = bench_now_ns();
+	for (i = 0; i < npages && status == 0; i++) {
+		status = mimix_zram_store(zram, i, set + i * MIMIX_ZRAM_PAGE);
+	}
+	elapsed = bench_now_ns() - start;
+	bench_phase_end(ctx, "store");
+	if (status != 0) {
+		perror("bench_zram: store");
+		mimix_zram_destroy(zram);
+		free(zram);
+		free(set);
+		return -1;
+	}
+	bench_metric(ctx, "store", (double) total / (double) elapsed, "GB/s",
+			BENCH_HIGHER_BETTER);
+
+	bench_phase_begin(ctx);
+	start = bench_now_ns();
+	for (i = 0; i < npages; i++) {
+		errors += (mimix_zram_load(zram, i, page) != 0);
+	}
+	elapsed = bench_now_ns() - start;
+	bench_phase_end(ctx, "load");
+	bench_metric(ctx, "load", (double) total / (double) elapsed, "GB/s",
+			BENCH_HIGHER_BETTER);
+
+	/* Untimed pass: every page must come back intact */
+	for (i = 0; i < npages; i++) {
+		errors += (mimix_zram_load(zram, i, page) != 0 || memcmp(page,
+				set + i * MIMIX_ZRAM_PAGE, MIMIX_ZRAM_PAGE) != 0);
+	}
+
+	used = mimix_zram_memory_used(zram);
+	printf("  pages: %lu, same-filled: %lu, raw: %lu, spans: %lu KiB each\n",
+			zram->stats.pages, zram->stats.same_filled, zram->stats.raw,
+			(unsigned long) MIMIX_ZRAM_SPAN / 1024);
+	bench_metric(ctx, "ratio", (double) (zram->stats.pages
+			- zram->stats.same_filled) * MIMIX_ZRAM_PAGE
+			/ (double) zram->stats.compressed_bytes, "x", BENCH_HIGHER_BETTER);
+	bench_metric(ctx, "effective_ratio", (double) total / (double) used, "x",
+			BENCH_HIGHER_BETTER);
+	bench_metric(ctx, "saved", ((double) total - (double) used)
+			/ BENCH_ZRAM_MB, "MiB", BENCH_HIGHER_BETTER);
+	bench_metric(ctx, "same_filled", 100.0 * (double) zram->stats.same_filled
+			/ (double) npages, "%", BENCH_HIGHER_BETTER);
+
+	status = bench_zram_codec(ctx, zram, set, npages);
+	if (errors != 0) {
+		fprintf(stderr, "bench_zram: %lu pages failed to load\n", errors);
+		status = -1;
+	}
+	mimix_zram_destroy(zram);
+	free(zram);
+	free(set);
+	return status;
+}
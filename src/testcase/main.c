@@ -13,17 +13,70 @@
 #include <assert.h>
 #include <headers/ansi.h>
 #include <headers/limits.h>
+#include <headers/perf.h>
+#include <headers/trace.h>
+#include <headers/stream.h>
+#include <headers/ipc.h>
+#include <headers/event.h>
+#include <headers/paging.h>
+#include <headers/zram.h>
+#include <headers/snapshot.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
 
 #ifdef _MIMIX_PTHREADS_OPTIMIZED
 #include <pthread.h>
 #endif
 
+/* Maximum number of cases recorded by the harness */
+#define MIMIX_TEST_MAX 16
+
+/* Trace overhead check: enough events to wrap the per-thread ring */
+#define MIMIX_TRACE_TEST_EVENTS  (4 * MIMIX_TRACE_BUFFER_EVENTS)
+#define MIMIX_TRACE_BUDGET_NS    20.0
+#define MIMIX_TRACE_BOOKKEEP_NS  5.0   /* Cost above the bare TSC read */
+#define MIMIX_TRACE_TEST_DIR     "/tmp/mimix-trace-XXXXXX"
+
+/* Stream round trip: straddles the writer buffer and many reader chunks */
+#define MIMIX_STREAM_TEST_DIR    "/tmp/mimix-stream-XXXXXX"
+#define MIMIX_STREAM_TEST_SMALL  4099
+#define MIMIX_STREAM_TEST_LARGE  (2 * MIMIX_STREAM_WRITE_BUFFER + 777)
+#define MIMIX_STREAM_TEST_CHUNK  (64 * 1024)
+
+/* IPC grants: a multi-megabyte payload crosses a fork without copying */
+#define MIMIX_IPC_TEST_ARENA     (8UL * 1024 * 1024)
+#define MIMIX_IPC_TEST_BYTES     (3UL * 1024 * 1024 + 123)
+#define MIMIX_IPC_TEST_WAIT_MS   10000L
+
+/* Event dispatch: one burst must coalesce into a single handler call */
+#define MIMIX_EVENT_TEST_BURST   100
+#define MIMIX_EVENT_TEST_TICK_NS (1000UL * 1000)
+#define MIMIX_EVENT_TEST_PASSES  500
+
+/* Paging: small pages, a huge region, and a second ASID at the same va */
+#define MIMIX_PT_TEST_POOL       64
+#define MIMIX_PT_TEST_SMALL_VA   0x400000UL
+#define MIMIX_PT_TEST_SMALL_PA   0x10000000UL
+#define MIMIX_PT_TEST_HUGE_VA    0x40000000UL
+#define MIMIX_PT_TEST_HUGE_PA    0x80000000UL
+#define MIMIX_PT_TEST_HUGE_LEN   (4UL * 1024 * 1024)
+
+/* Compressed store: one page of each kind */
+#define MIMIX_ZRAM_TEST_PAGES    8
+#define MIMIX_ZRAM_TEST_FILL     0x5A5A5A5A5A5A5A5AUL
+
+/* Snapshot: one image, restored, then reopened as stale and as damaged */
+#define MIMIX_SNAP_TEST_DIR      "/tmp/mimix-snapshot-XXXXXX"
+
 /* Test Result Structure with Cache Alignment */
 typedef struct test_result {
 	char test_name[64];
 	int passed;
 	size_t memory_alignment;
 	double execution_time;
+	mimix_perf_sample_t counters;
 } test_result_t;
 
 /* Pure Function: Verify ANSI compliance macros
@@ -165,12 +218,171 @@ static void mimix_aligned_free(void *ptr) {
 	}
 }
 
+/* Close a test case: stop the counter group and record wall time
+ * Complexity: O(1) - One group read
+ */
+static void mimix_test_sample(mimix_perf_group_t *perf, test_result_t *result) {
+	mimix_perf_end(perf, &result->counters);
+	result->execution_time = (double) result->counters.wall_ns / 1e9;
+}
+
+/* Counter Workload: dependent integer chain plus a strided walk
+ * Complexity: O(n) - Touches every cache line of the buffer once
+ */
+static unsigned long mimix_perf_workload(const unsigned char *buf, size_t len) {
+	unsigned long acc = 0x9E3779B97F4A7C15UL;
+	size_t i;
+
+	for (i = 0; i < len; i += _MIMIX_CACHE_LINE) {
+		acc ^= buf[i];
+		acc *= 0xBF58476D1CE4E5B9UL;
+	}
+	return acc;
+}
+
+/* Check a Chrome export: every slot of the wrapped ring is one of the
+ * timed scope's begin/end events, in equal numbers
+ * Complexity: O(n) - One pass over the file
+ */
+static int mimix_trace_test_verify(const char *path) {
+	FILE *f = fopen(path, "r");
+	char line[256];
+	unsigned long begins = 0, ends = 0;
+	int ok;
+
+	if (f == NULL) {
+		return 0;
+	}
+	ok = (fgetc(f) == '{');
+	while (fgets(line, sizeof(line), f) != NULL) {
+		begins += (strstr(line,
+				"{\"name\":\"trace_test\",\"ph\":\"B\"") != NULL);
+		ends += (strstr(line,
+				"{\"name\":\"trace_test\",\"ph\":\"E\"") != NULL);
+	}
+	fclose(f);
+	return ok && begins == MIMIX_TRACE_BUFFER_EVENTS / 2 && ends == begins;
+}
+
+/* Pure Function: Byte expected at a given stream offset
+ * Complexity: O(1)
+ */
+static unsigned char __attribute__((const)) mimix_stream_pattern(
+		unsigned long pos) {
+	return (unsigned char) ((pos ^ (pos >> 9)) * 31UL);
+}
+
+/* Write len pattern bytes starting at *pos through the stream writer
+ * Complexity: O(n)
+ */
+static int mimix_stream_test_put(mimix_stream_writer_t *w, unsigned char *buf,
+		size_t len, unsigned long *pos) {
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		buf[i] = mimix_stream_pattern(*pos + i);
+	}
+	*pos += len;
+	return mimix_stream_write(w, buf, len);
+}
+
+/* Read the test file back in the given mode and verify every byte
+ * Complexity: O(n)
+ */
+static int mimix_stream_test_verify(const char *path, int flags,
+		unsigned long expected) {
+	mimix_stream_reader_t r;
+	mimix_slice_t slice;
+	unsigned long pos = 0;
+	int status;
+	int ok = 1;
+	size_t i;
+
+	if (mimix_stream_open(&r, path, flags,
+			MIMIX_STREAM_TEST_CHUNK) != 0) {
+		return 0;
+	}
+	while ((status = mimix_stream_next(&r, &slice)) > 0) {
+		ok &= (slice.offset == pos);
+		for (i = 0; i < slice.len; i++) {
+			ok &= (slice.data[i] == mimix_stream_pattern(pos + i));
+		}
+		pos += slice.len;
+	}
+	mimix_stream_close(&r);
+
+	return ok && status == 0 && pos == expected;
+}
+
+/* IPC Peer Process: verify a granted payload in place and exercise the
+ * advisory rights and revocation checks; reports through the reply tag
+ * Complexity: O(n) - One pass over the payload
+ */
+static int mimix_ipc_test_peer(int fd) {
+	mimix_ipc_channel_t ch;
+	mimix_ipc_desc_t desc, reply;
+	const unsigned char *data;
+	unsigned long i;
+	int ok = 1;
+
+	/* No ring to reply on: the parent's bounded recv times out */
+	if (mimix_ipc_attach(&ch, fd, 1) != 0) {
+		return 1;
+	}
+	memset(&reply, 0, sizeof(reply));
+
+	/* Message 1: live read-only grant; every failed exit replies tag 0 */
+	if (mimix_ipc_recv_timed(&ch, &desc, MIMIX_IPC_TEST_WAIT_MS) != 0) {
+		mimix_ipc_send(&ch, &reply);
+		mimix_ipc_detach(&ch);
+		return 1;
+	}
+	data = (const unsigned char *) mimix_ipc_map(&ch, &desc,
+			MIMIX_IPC_RIGHT_READ);
+	ok &= (data != NULL && desc.length == MIMIX_IPC_TEST_BYTES);
+	for (i = 0; data != NULL && i < desc.length; i++) {
+		ok &= (data[i] == mimix_stream_pattern(i));
+	}
+	ok &= (mimix_ipc_map(&ch, &desc, MIMIX_IPC_RIGHT_WRITE) == NULL
+			&& errno == EACCES);
+	ok &= (mimix_ipc_release(&ch, desc.cap) == 0);
+	reply.tag = (unsigned long) ok;
+	mimix_ipc_send(&ch, &reply);
+
+	/* Message 2: handle revoked before it was sent */
+	if (mimix_ipc_recv_timed(&ch, &desc, MIMIX_IPC_TEST_WAIT_MS) != 0) {
+		reply.tag = 0;
+		mimix_ipc_send(&ch, &reply);
+		mimix_ipc_detach(&ch);
+		return 1;
+	}
+	reply.tag = (mimix_ipc_map(&ch, &desc, MIMIX_IPC_RIGHT_READ) == NULL
+			&& errno == ESTALE);
+	mimix_ipc_send(&ch, &reply);
+
+	mimix_ipc_detach(&ch);
+	return 0;
+}
+
+/* Event Handler: accumulate per-vector counts and invocations
+ * Complexity: O(1)
+ */
+static void mimix_event_test_handler(unsigned int vector, unsigned long count,
+		void *arg) {
+	unsigned long *counts = (unsigned long *) arg;
+
+	counts[2 * vector] += count;
+	counts[2 * vector + 1]++;
+}
+
 /* Main Test Harness with Performance Measurement
  * Complexity: O(n) - Linear verification of all test cases
  * Functional Testing: White-box validation of all constraints
  */
 int __attribute__((warn_unused_result)) main(void) {
-	test_result_t results[8];
+	test_result_t results[MIMIX_TEST_MAX];
+	mimix_perf_group_t perf;
+	int perf_counters;
 	int test_index = 0;
 	int total_passed = 0;
 	int i; /* C90 requires variable declaration at start */
@@ -182,17 +394,23 @@ int __attribute__((warn_unused_result)) main(void) {
 	printf("  Pointer Size: %lu bytes\n", (unsigned long) _MIMIX_POINTER_SIZE);
 	printf("  Alignment: %d bytes\n", _MIMIX_ALIGNMENT);
 	printf("  Cache Line: %d bytes\n", _MIMIX_CACHE_LINE);
+	perf_counters = mimix_perf_open(&perf);
+	printf("  Perf Counters: %d/%d available\n", perf_counters,
+			MIMIX_PERF_NCOUNTERS);
 	printf("\n");
 
 	/* Test 1: ANSI Compliance */
+	mimix_perf_begin(&perf);
 	results[test_index].passed = mimix_verify_ansi_compliance();
 	strncpy(results[test_index].test_name, "ANSI_Compliance", 64);
 	results[test_index].memory_alignment = _MIMIX_ALIGNMENT;
 	printf("Test 1 - ANSI Compliance: %s\n",
 			results[test_index].passed ? "PASSED" : "FAILED");
+	mimix_test_sample(&perf, &results[test_index]);
 	test_index++;
 
 	/* Test 2: Memory Alignment */
+	mimix_perf_begin(&perf);
 	{
 		void *aligned_mem = mimix_aligned_malloc(1024, _MIMIX_ALIGNMENT);
 		if (aligned_mem) {
@@ -209,17 +427,21 @@ int __attribute__((warn_unused_result)) main(void) {
 		printf("Test 2 - %d-byte Alignment: %s (offset: %lu)\n",
 		_MIMIX_ALIGNMENT, results[test_index].passed ? "PASSED" : "FAILED",
 				(unsigned long) results[test_index].memory_alignment);
+		mimix_test_sample(&perf, &results[test_index]);
 		test_index++;
 	}
 
 	/* Test 3: Integer Limits */
+	mimix_perf_begin(&perf);
 	results[test_index].passed = mimix_validate_integer_limits();
 	strncpy(results[test_index].test_name, "Integer_Limits", 64);
 	printf("Test 3 - Integer Limits: %s\n",
 			results[test_index].passed ? "PASSED" : "FAILED");
+	mimix_test_sample(&perf, &results[test_index]);
 	test_index++;
 
 	/* Test 4: POSIX Limits Enhancement */
+	mimix_perf_begin(&perf);
 #ifdef _POSIX_SOURCE
 	results[test_index].passed = (ARG_MAX > _POSIX_ARG_MAX)
 			&& (OPEN_MAX > _POSIX_OPEN_MAX) && (PATH_MAX > _POSIX_PATH_MAX);
@@ -229,9 +451,11 @@ int __attribute__((warn_unused_result)) main(void) {
 	strncpy(results[test_index].test_name, "POSIX_Enhancement", 64);
 	printf("Test 4 - POSIX Limits Enhanced: %s\n",
 			results[test_index].passed ? "PASSED" : "FAILED");
+	mimix_test_sample(&perf, &results[test_index]);
 	test_index++;
 
 	/* Test 5: SIMD Vectorized Validation */
+	mimix_perf_begin(&perf);
 #ifdef __GNUC__
 	{
 		/* Prepare aligned array of limits for SIMD processing */
@@ -269,16 +493,19 @@ int __attribute__((warn_unused_result)) main(void) {
 		strncpy(results[test_index].test_name, "SIMD_Validation", 64);
 		printf("Test 5 - SIMD Vectorized Check: %s\n",
 				results[test_index].passed ? "PASSED" : "FAILED");
+		mimix_test_sample(&perf, &results[test_index]);
 		test_index++;
 	}
 #else
     results[test_index].passed = 1;  /* SIMD not available on non-GCC */
     strncpy(results[test_index].test_name, "SIMD_Validation", 64);
     printf("Test 5 - SIMD Vectorized Check: SKIPPED (non-GCC compiler)\n");
+    mimix_test_sample(&perf, &results[test_index]);
     test_index++;
 #endif
 
 	/* Test 6: PThreads Concurrent Validation */
+	mimix_perf_begin(&perf);
 #ifdef _MIMIX_PTHREADS_OPTIMIZED
 	{
 		pthread_t threads[4];
@@ -307,33 +534,609 @@ int __attribute__((warn_unused_result)) main(void) {
 		strncpy(results[test_index].test_name, "PThreads_Validation", 64);
 		printf("Test 6 - PThreads Concurrent: %s\n",
 				results[test_index].passed ? "PASSED" : "FAILED");
+		mimix_test_sample(&perf, &results[test_index]);
 		test_index++;
 	}
 #else
     results[test_index].passed = 1;  /* PThreads not enabled */
     strncpy(results[test_index].test_name, "PThreads_Validation", 64);
     printf("Test 6 - PThreads Concurrent: SKIPPED (PThreads not enabled)\n");
+    mimix_test_sample(&perf, &results[test_index]);
     test_index++;
 #endif
 
 	/* Test 7: System Limits Coherence */
+	mimix_perf_begin(&perf);
 	results[test_index].passed = (SSIZE_MAX > 0)
 			&& (SIZE_MAX > (unsigned long long) SSIZE_MAX) && (OPEN_MAX <= 1024)
 			&& (PATH_MAX >= 255);
 	strncpy(results[test_index].test_name, "System_Limits", 64);
 	printf("Test 7 - System Limits Coherence: %s\n",
 			results[test_index].passed ? "PASSED" : "FAILED");
+	mimix_test_sample(&perf, &results[test_index]);
 	test_index++;
 
 	/* Test 8: Architecture Verification */
+	mimix_perf_begin(&perf);
 	results[test_index].passed = (_MIMIX_POINTER_SIZE == 4
 			|| _MIMIX_POINTER_SIZE == 8);
 	strncpy(results[test_index].test_name, "Architecture_Verification", 64);
 	printf("Test 8 - Architecture Verification: %s (pointer size: %lu)\n",
 			results[test_index].passed ? "PASSED" : "FAILED",
 			(unsigned long) _MIMIX_POINTER_SIZE);
+	mimix_test_sample(&perf, &results[test_index]);
 	test_index++;
 
+	/* Test 9: Performance Counter Surface */
+	mimix_perf_begin(&perf);
+	{
+		size_t work_len = 4 * MIMIX_L2_CACHE_SIZE;
+		unsigned char *work = mimix_aligned_malloc(work_len, _MIMIX_ALIGNMENT);
+		volatile unsigned long sink = 0;
+		int counters_ok = 1;
+
+		if (work) {
+			memset(work, 0x5A, work_len);
+			sink = mimix_perf_workload(work, work_len);
+			mimix_aligned_free(work);
+		} else {
+			counters_ok = 0;
+		}
+		(void) sink;
+		mimix_test_sample(&perf, &results[test_index]);
+
+		/* With counters: cycles and instructions must both tick.
+		 * Without: the harness must still record wall time. */
+		if (perf.available
+				&& (results[test_index].counters.valid_mask & 3UL) == 3UL) {
+			counters_ok &= results[test_index].counters.value[MIMIX_PERF_CYCLES]
+					> 0;
+			counters_ok &=
+					results[test_index].counters.value[MIMIX_PERF_INSTRUCTIONS]
+							> 0;
+		}
+		counters_ok &= (results[test_index].counters.wall_ns > 0);
+
+		results[test_index].passed = counters_ok;
+		strncpy(results[test_index].test_name, "Perf_Counters", 64);
+		printf("Test 9 - Performance Counters: %s (%s)\n",
+				results[test_index].passed ? "PASSED" : "FAILED",
+				perf.available ? "hardware" : "wall time only");
+		test_index++;
+	}
+
+	/* Test 10: Trace Event Overhead and Chrome Export */
+	mimix_perf_begin(&perf);
+	{
+		unsigned long t0, t1, n;
+		volatile unsigned long tsc_sink = 0;
+		double ns_per_event = 0.0;
+		double ns_per_tsc = 0.0;
+		char trace_dir[] = MIMIX_TRACE_TEST_DIR;
+		char trace_path[sizeof(MIMIX_TRACE_TEST_DIR) + 16];
+		int trace_ok = (mimix_trace_init() == 0);
+
+		/* First event attaches the thread buffer outside the timed loop */
+		mimix_trace_record("attach", MIMIX_TRACE_PHASE_BEGIN);
+		mimix_trace_record("attach", MIMIX_TRACE_PHASE_END);
+
+		/* Best of several passes filters scheduler noise */
+		for (i = 0; i < 5; i++) {
+			double pass_ns;
+
+			t0 = mimix_trace_clock_ns();
+			for (n = 0; n < MIMIX_TRACE_TEST_EVENTS; n += 2) {
+				mimix_trace_record("trace_test", MIMIX_TRACE_PHASE_BEGIN);
+				mimix_trace_record("trace_test", MIMIX_TRACE_PHASE_END);
+			}
+			t1 = mimix_trace_clock_ns();
+			pass_ns = (double) (t1 - t0) / (double) n;
+			if (i == 0 || pass_ns < ns_per_event) {
+				ns_per_event = pass_ns;
+			}
+
+			t0 = mimix_trace_clock_ns();
+			for (n = 0; n < MIMIX_TRACE_TEST_EVENTS; n++) {
+				tsc_sink += mimix_trace_rdtsc();
+			}
+			t1 = mimix_trace_clock_ns();
+			pass_ns = (double) (t1 - t0) / (double) n;
+			if (i == 0 || pass_ns < ns_per_tsc) {
+				ns_per_tsc = pass_ns;
+			}
+		}
+
+		/* Hypervisors may trap rdtsc; the absolute budget applies only when
+		 * the host's bare TSC read leaves room for the bookkeeping. */
+		trace_ok &= (ns_per_event - ns_per_tsc < MIMIX_TRACE_BOOKKEEP_NS);
+		if (ns_per_tsc < MIMIX_TRACE_BUDGET_NS - MIMIX_TRACE_BOOKKEEP_NS) {
+			trace_ok &= (ns_per_event < MIMIX_TRACE_BUDGET_NS);
+		}
+		trace_ok &= (mimix_trace_overwritten() > 0);
+
+		/* Private directory: no collisions, no planted symlinks */
+		if (mkdtemp(trace_dir) != NULL) {
+			sprintf(trace_path, "%s/trace.json", trace_dir);
+			trace_ok &= (mimix_trace_export_chrome(trace_path) == 0
+					&& mimix_trace_test_verify(trace_path));
+			remove(trace_path);
+			rmdir(trace_dir);
+		} else {
+			trace_ok = 0;
+		}
+		mimix_trace_shutdown();
+
+		mimix_test_sample(&perf, &results[test_index]);
+		results[test_index].passed = trace_ok;
+		strncpy(results[test_index].test_name, "Trace_Overhead", 64);
+		printf("Test 10 - Trace Overhead: %s (%.1f ns/event, rdtsc %.1f ns)\n",
+				results[test_index].passed ? "PASSED" : "FAILED",
+				ns_per_event, ns_per_tsc);
+		test_index++;
+	}
+
+	/* Test 11: Streaming I/O Round Trip */
+	mimix_perf_begin(&perf);
+	{
+		mimix_stream_writer_t sw;
+		unsigned char *stream_buf = malloc(MIMIX_STREAM_TEST_LARGE);
+		char stream_dir[] = MIMIX_STREAM_TEST_DIR;
+		char stream_path[sizeof(MIMIX_STREAM_TEST_DIR) + 16];
+		unsigned long pos = 0;
+		/* Private directory: no collisions, no planted symlinks */
+		int stream_ok = (stream_buf != NULL && mkdtemp(stream_dir) != NULL);
+
+		sprintf(stream_path, "%s/stream.bin", stream_dir);
+		if (stream_ok && mimix_stream_writer_open(&sw, stream_path) == 0) {
+			/* Small writes coalesce, the large one partly bypasses */
+			while (pos < MIMIX_STREAM_WRITE_BUFFER / 2) {
+				stream_ok &= (mimix_stream_test_put(&sw, stream_buf,
+						MIMIX_STREAM_TEST_SMALL, &pos) == 0);
+			}
+			stream_ok &= (mimix_stream_test_put(&sw, stream_buf,
+					MIMIX_STREAM_TEST_LARGE, &pos) == 0);
+			stream_ok &= (mimix_stream_test_put(&sw, stream_buf,
+					MIMIX_STREAM_TEST_SMALL, &pos) == 0);
+			stream_ok &= (mimix_stream_writer_close(&sw) == 0);
+
+			stream_ok &= mimix_stream_test_verify(stream_path,
+					MIMIX_STREAM_FORCE_MMAP, pos);
+			stream_ok &= mimix_stream_test_verify(stream_path,
+					MIMIX_STREAM_FORCE_PREAD, pos);
+			remove(stream_path);
+		} else {
+			stream_ok = 0;
+		}
+		rmdir(stream_dir);
+		free(stream_buf);
+
+		mimix_test_sample(&perf, &results[test_index]);
+		results[test_index].passed = stream_ok;
+		strncpy(results[test_index].test_name, "Stream_IO", 64);
+		printf("Test 11 - Streaming I/O (mmap + pread): %s (%lu bytes)\n",
+				results[test_index].passed ? "PASSED" : "FAILED", pos);
+		test_index++;
+	}
+
+	/* Test 12: Cross-Process IPC Grants */
+	mimix_perf_begin(&perf);
+	{
+		mimix_ipc_channel_t ch;
+		mimix_ipc_desc_t desc, reply;
+		unsigned char *payload;
+		unsigned long j;
+		int created = (mimix_ipc_create(&ch, MIMIX_IPC_TEST_ARENA) == 0);
+		int ipc_ok = 0;
+		int child_status = 1;
+		pid_t child = -1;
+
+		if (created) {
+			fflush(stdout);
+			child = fork();
+			if (child == 0) {
+				_exit(mimix_ipc_test_peer(ch.fd));
+			}
+		}
+		if (child > 0 && mimix_ipc_grant(&ch, MIMIX_IPC_TEST_BYTES,
+				MIMIX_IPC_RIGHT_READ, &desc.cap, (void **) &payload) == 0) {
+			for (j = 0; j < MIMIX_IPC_TEST_BYTES; j++) {
+				payload[j] = mimix_stream_pattern(j);
+			}
+			desc.offset = 0;
+			desc.length = MIMIX_IPC_TEST_BYTES;
+			desc.tag = 1;
+			/* Bounded recvs: a peer that died still lets us reach waitpid */
+			ipc_ok = (mimix_ipc_send(&ch, &desc) == 0
+					&& mimix_ipc_recv_timed(&ch, &reply,
+							MIMIX_IPC_TEST_WAIT_MS) == 0 && reply.tag == 1);
+
+			/* Released by the peer: the owner's handle is now stale */
+			ipc_ok &= (mimix_ipc_revoke(&ch, desc.cap) != 0
+					&& errno == ESTALE);
+
+			ipc_ok &= (mimix_ipc_grant(&ch, MIMIX_IPC_BLOCK_SIZE,
+					MIMIX_IPC_RIGHT_READ, &desc.cap, (void **) &payload) == 0
+					&& mimix_ipc_revoke(&ch, desc.cap) == 0);
+			desc.length = MIMIX_IPC_BLOCK_SIZE;
+			ipc_ok &= (mimix_ipc_send(&ch, &desc) == 0
+					&& mimix_ipc_recv_timed(&ch, &reply,
+							MIMIX_IPC_TEST_WAIT_MS) == 0 && reply.tag == 1);
+		}
+		if (child > 0) {
+			waitpid(child, &child_status, 0);
+			ipc_ok &= (WIFEXITED(child_status)
+					&& WEXITSTATUS(child_status) == 0);
+		}
+		if (created) {
+			mimix_ipc_detach(&ch);
+		}
+
+		mimix_test_sample(&perf, &results[test_index]);
+		results[test_index].passed = ipc_ok;
+		strncpy(results[test_index].test_name, "IPC_Grants", 64);
+		printf("Test 12 - IPC Grants (memfd + futex): %s (%lu bytes)\n",
+				results[test_index].passed ? "PASSED" : "FAILED",
+				MIMIX_IPC_TEST_BYTES);
+		test_index++;
+	}
+
+	/* Test 13: Batched Event Dispatch and Coalescing */
+	mimix_perf_begin(&perf);
+	{
+		mimix_event_loop_t loop, rejected;
+		unsigned long counts[6] = { 0, 0, 0, 0, 0, 0 };  /* Events, calls */
+		sigset_t mask;
+		int passes = 0;
+		int k;
+		int event_ok = (mimix_event_init(&loop, MIMIX_EVENT_HOLDOFF_MAX) == 0);
+
+		event_ok &= (mimix_event_init(&rejected, MIMIX_EVENT_HOLDOFF_LIMIT + 1)
+				!= 0 && errno == EINVAL);
+		for (k = 0; k < 3; k++) {
+			event_ok &= (mimix_event_register(&loop, (unsigned int) k,
+					mimix_event_test_handler, counts) == 0);
+		}
+		event_ok &= (mimix_event_register(&loop, MIMIX_EVENT_VECTORS,
+				mimix_event_test_handler, counts) != 0 && errno == EINVAL);
+		event_ok &= (mimix_event_add_eventfd(&loop, 0) == 0);
+		event_ok &= (mimix_event_add_eventfd(&loop, 0) != 0 && errno == EBUSY);
+
+		/* A burst is one handler call and arms the hold-off */
+		for (k = 0; k < MIMIX_EVENT_TEST_BURST; k++) {
+			event_ok &= (mimix_event_raise(&loop, 0, 1) == 0);
+		}
+		event_ok &= (mimix_event_dispatch(&loop, 0) == MIMIX_EVENT_TEST_BURST
+				&& counts[1] == 1 && loop.holdoff_ns == MIMIX_EVENT_HOLDOFF_MIN);
+
+		/* A lone event is dispatched after the hold-off, then idle again */
+		event_ok &= (mimix_event_raise(&loop, 0, 1) == 0);
+		event_ok &= (mimix_event_dispatch(&loop, 0) == 1
+				&& loop.stats.holdoffs == 1 && loop.holdoff_ns == 0);
+
+		/* Timer and signal sources share the same table */
+		event_ok &= (mimix_event_add_timer(&loop, 1,
+				MIMIX_EVENT_TEST_TICK_NS) == 0);
+		event_ok &= (mimix_event_add_signal(&loop, 2, SIGUSR1) == 0);
+		event_ok &= (raise(SIGUSR1) == 0);
+		while (event_ok && (counts[2] < 3 || counts[4] < 1)
+				&& passes++ < MIMIX_EVENT_TEST_PASSES) {
+			event_ok &= (mimix_event_dispatch(&loop, 10) >= 0);
+		}
+		event_ok &= (counts[0] == MIMIX_EVENT_TEST_BURST + 1
+				&& counts[2] >= 3 && counts[4] == 1);
+		mimix_event_destroy(&loop);
+
+		/* The loop hands SIGUSR1 back unblocked */
+		event_ok &= (pthread_sigmask(SIG_BLOCK, NULL, &mask) == 0
+				&& !sigismember(&mask, SIGUSR1));
+
+		mimix_test_sample(&perf, &results[test_index]);
+		results[test_index].passed = event_ok;
+		strncpy(results[test_index].test_name, "Event_Dispatch", 64);
+		printf("Test 13 - Event Dispatch (epoll batch): %s (%lu dispatches)\n",
+				results[test_index].passed ? "PASSED" : "FAILED",
+				loop.stats.dispatches);
+		test_index++;
+	}
+
+	/* Test 14: Radix Page Tables and Software TLB */
+	mimix_perf_begin(&perf);
+	{
+		mimix_page_pool_t pool;
+		mimix_pt_space_t space, other;
+		mimix_tlb_t *tlb = (mimix_tlb_t *) malloc(sizeof(mimix_tlb_t));
+		mimix_tlb_batch_t batch;
+		unsigned long pa = 0, pte = 0;
+		unsigned long free_pages, starve;
+		unsigned int shift = 0;
+		int pt_ok = (tlb != NULL
+				&& mimix_page_pool_init(&pool, MIMIX_PT_TEST_POOL) == 0);
+
+		if (pt_ok) {
+			mimix_tlb_init(tlb);
+			pt_ok &= (mimix_pt_init(&space, &pool, 1) == 0
+					&& mimix_pt_init(&other, &pool, 2) == 0);
+			pt_ok &= (mimix_pt_map(&space, MIMIX_PT_TEST_SMALL_VA,
+					MIMIX_PT_TEST_SMALL_PA, 16 * MIMIX_PAGE_SIZE,
+					MIMIX_PTE_WRITE | MIMIX_PTE_USER) == 0);
+			pt_ok &= (mimix_pt_map(&space, MIMIX_PT_TEST_HUGE_VA,
+					MIMIX_PT_TEST_HUGE_PA, MIMIX_PT_TEST_HUGE_LEN,
+					MIMIX_PTE_WRITE | MIMIX_PT_ALLOW_HUGE) == 0);
+			pt_ok &= (mimix_pt_map(&space, MIMIX_PT_TEST_SMALL_VA,
+					MIMIX_PT_TEST_SMALL_PA, MIMIX_PAGE_SIZE, 0) != 0
+					&& errno == EEXIST);
+
+			/* Huge leaf, then a miss followed by a hit */
+			pt_ok &= (mimix_pt_walk(&space, MIMIX_PT_TEST_HUGE_VA + 12345,
+					&pte, &shift) == 0 && shift == 21);
+			pt_ok &= (mimix_tlb_translate(tlb, &space,
+					MIMIX_PT_TEST_SMALL_VA + 0x123, MIMIX_TLB_WRITE, &pa) == 0
+					&& pa == MIMIX_PT_TEST_SMALL_PA + 0x123);
+			pt_ok &= (mimix_tlb_translate(tlb, &space,
+					MIMIX_PT_TEST_SMALL_VA + 0x456, MIMIX_TLB_READ, &pa) == 0
+					&& tlb->stats.hits == 1 && tlb->stats.misses == 1);
+
+			/* Same va in another ASID coexists in the TLB */
+			pt_ok &= (mimix_pt_map(&other, MIMIX_PT_TEST_SMALL_VA,
+					MIMIX_PT_TEST_HUGE_PA, MIMIX_PAGE_SIZE, 0) == 0);
+			pt_ok &= (mimix_tlb_translate(tlb, &other,
+					MIMIX_PT_TEST_SMALL_VA, MIMIX_TLB_READ, &pa) == 0
+					&& pa == MIMIX_PT_TEST_HUGE_PA);
+			pt_ok &= (mimix_tlb_translate(tlb, &space,
+					MIMIX_PT_TEST_SMALL_VA, MIMIX_TLB_READ, &pa) == 0
+					&& pa == MIMIX_PT_TEST_SMALL_PA && tlb->stats.hits == 2);
+
+			/* Read-only after a batched shootdown */
+			mimix_tlb_batch_init(&batch, space.asid);
+			pt_ok &= (mimix_pt_protect(&space, MIMIX_PT_TEST_SMALL_VA,
+					MIMIX_PAGE_SIZE, MIMIX_PTE_USER, &batch) == 0
+					&& batch.count == 1);
+			mimix_tlb_shootdown(tlb, 1, &batch);
+			pt_ok &= (mimix_tlb_translate(tlb, &space,
+					MIMIX_PT_TEST_SMALL_VA, MIMIX_TLB_WRITE, &pa) != 0
+					&& errno == EACCES);
+
+			/* Punch a page out of the huge region: splits the leaf */
+			pt_ok &= (mimix_tlb_translate(tlb, &space,
+					MIMIX_PT_TEST_HUGE_VA + MIMIX_PAGE_SIZE, MIMIX_TLB_READ,
+					&pa) == 0);
+			pt_ok &= (mimix_pt_unmap(&space, MIMIX_PT_TEST_HUGE_VA
+					+ MIMIX_PAGE_SIZE, MIMIX_PAGE_SIZE, &batch) == 0);
+			mimix_tlb_shootdown(tlb, 1, &batch);
+			pt_ok &= (mimix_tlb_translate(tlb, &space,
+					MIMIX_PT_TEST_HUGE_VA + MIMIX_PAGE_SIZE, MIMIX_TLB_READ,
+					&pa) != 0 && errno == EFAULT);
+			pt_ok &= (mimix_tlb_translate(tlb, &space,
+					MIMIX_PT_TEST_HUGE_VA + 2 * MIMIX_PAGE_SIZE + 7,
+					MIMIX_TLB_WRITE, &pa) == 0 && pa == MIMIX_PT_TEST_HUGE_PA
+					+ 2 * MIMIX_PAGE_SIZE + 7);
+			pt_ok &= (mimix_pt_protect(&space, MIMIX_PT_TEST_HUGE_VA,
+					2 * MIMIX_PAGE_SIZE, 0, NULL) != 0 && errno == ENOMEM);
+
+			/* Unmapping everything returns every table but the roots */
+			pt_ok &= (mimix_pt_unmap(&space, MIMIX_PT_TEST_SMALL_VA,
+					16 * MIMIX_PAGE_SIZE, NULL) == 0
+					&& mimix_pt_unmap(&space, MIMIX_PT_TEST_HUGE_VA,
+					MIMIX_PT_TEST_HUGE_LEN, NULL) == 0 && space.tables == 1);
+
+			/* Starved pool: failed maps, in the first chunk and after one
+			 * page went in, hand back every table they took
+			 */
+			free_pages = pool.nfree;
+			for (starve = 2; starve <= 3; starve++) {
+				pool.nfree = starve;
+				pt_ok &= (mimix_pt_map(&space, MIMIX_PT_TEST_HUGE_VA
+						- MIMIX_PAGE_SIZE, MIMIX_PT_TEST_SMALL_PA,
+						2 * MIMIX_PAGE_SIZE, 0) != 0 && errno == ENOMEM
+						&& pool.nfree == starve && space.tables == 1);
+			}
+			pool.nfree = free_pages;
+			mimix_pt_destroy(&space);
+			mimix_pt_destroy(&other);
+			pt_ok &= (pool.nfree == pool.npages);
+			mimix_page_pool_destroy(&pool);
+		}
+		free(tlb);
+
+		mimix_test_sample(&perf, &results[test_index]);
+		results[test_index].passed = pt_ok;
+		strncpy(results[test_index].test_name, "Paging_TLB", 64);
+		printf("Test 14 - Page Tables + Software TLB: %s\n",
+				results[test_index].passed ? "PASSED" : "FAILED");
+		test_index++;
+	}
+
+	/* Test 15: Compressed page store */
+	mimix_perf_begin(&perf);
+	{
+		mimix_zram_t *zram = (mimix_zram_t *) malloc(sizeof(mimix_zram_t));
+		unsigned char *text = (unsigned char *) malloc(MIMIX_ZRAM_PAGE);
+		unsigned char *noise = (unsigned char *) malloc(MIMIX_ZRAM_PAGE);
+		unsigned char *out = (unsigned char *) malloc(MIMIX_ZRAM_PAGE);
+		unsigned char *packed = (unsigned char *)
+				malloc(MIMIX_LZ_BOUND(MIMIX_ZRAM_PAGE));
+		unsigned long seed = 0x9E3779B97F4A7C15UL;
+		unsigned long fill = MIMIX_ZRAM_TEST_FILL;
+		long packed_len = -1;
+		size_t k;
+		int zram_ok = (zram != NULL && text != NULL && noise != NULL
+				&& out != NULL && packed != NULL);
+
+		if (zram_ok) {
+			for (k = 0; k < MIMIX_ZRAM_PAGE; k++) {
+				text[k] = (unsigned char) ("mimix page "[k % 11] + (k / 512));
+				seed ^= seed << 13;
+				seed ^= seed >> 7;
+				seed ^= seed << 17;
+				noise[k] = (unsigned char) seed;
+			}
+
+			/* Codec: round trip, incompressible input, corrupt stream */
+			packed_len = mimix_lz_compress(text, MIMIX_ZRAM_PAGE, packed,
+					MIMIX_LZ_BOUND(MIMIX_ZRAM_PAGE));
+			zram_ok &= (packed_len > 0 && packed_len < MIMIX_ZRAM_PAGE / 4);
+			zram_ok &= (mimix_lz_decompress(packed, (size_t) packed_len, out,
+					MIMIX_ZRAM_PAGE) == MIMIX_ZRAM_PAGE
+					&& memcmp(out, text, MIMIX_ZRAM_PAGE) == 0);
+			zram_ok &= (mimix_lz_compress(noise, MIMIX_ZRAM_PAGE, packed,
+					MIMIX_ZRAM_MAX_OBJECT) < 0 && errno == ENOSPC);
+			packed[0] = 0x0F;
+			packed[1] = 0x01;
+			packed[2] = 0x00;
+			zram_ok &= (mimix_lz_decompress(packed, 3, out, MIMIX_ZRAM_PAGE) < 0
+					&& errno == EINVAL);
+
+			zram_ok &= (mimix_zram_init(zram, MIMIX_ZRAM_TEST_PAGES) == 0);
+		}
+		if (zram_ok) {
+			/* Same-filled pages take no pool memory */
+			memset(out, 0, MIMIX_ZRAM_PAGE);
+			zram_ok &= (mimix_zram_store(zram, 0, out) == 0
+					&& zram->slots[0].flags == MIMIX_ZRAM_SAME
+					&& zram->stats.pool_bytes == 0);
+			for (k = 0; k < MIMIX_ZRAM_PAGE / sizeof(fill); k++) {
+				memcpy(out + k * sizeof(fill), &fill, sizeof(fill));
+			}
+			zram_ok &= (mimix_zram_store(zram, 1, out) == 0
+					&& zram->stats.same_filled == 2);
+			zram_ok &= (mimix_zram_store(zram, 2, text) == 0
+					&& zram->slots[2].flags == MIMIX_ZRAM_COMPRESSED);
+			zram_ok &= (mimix_zram_store(zram, 3, noise) == 0
+					&& zram->slots[3].flags == MIMIX_ZRAM_RAW);
+
+			/* Every kind loads back byte for byte */
+			zram_ok &= (mimix_zram_load(zram, 1, out) == 0
+					&& memcmp(out, &fill, sizeof(fill)) == 0
+					&& memcmp(out, out + sizeof(fill),
+							MIMIX_ZRAM_PAGE - sizeof(fill)) == 0);
+			zram_ok &= (mimix_zram_load(zram, 2, out) == 0
+					&& memcmp(out, text, MIMIX_ZRAM_PAGE) == 0);
+			zram_ok &= (mimix_zram_load(zram, 3, out) == 0
+					&& memcmp(out, noise, MIMIX_ZRAM_PAGE) == 0);
+
+			/* Overwrite and discard return chunks to their class */
+			zram_ok &= (mimix_zram_store(zram, 3, text) == 0
+					&& zram->stats.raw == 0 && zram->stats.pages == 4);
+			mimix_zram_discard(zram, 2);
+			mimix_zram_discard(zram, 3);
+			zram_ok &= (mimix_zram_load(zram, 2, out) != 0 && errno == ENOENT);
+			zram_ok &= (zram->stats.compressed_bytes == 0
+					&& zram->stats.pages == 2);
+			for (k = 0; k < MIMIX_ZRAM_CLASSES; k++) {
+				zram_ok &= (zram->classes[k].used == 0);
+			}
+			mimix_zram_destroy(zram);
+		}
+		free(zram);
+		free(text);
+		free(noise);
+		free(out);
+		free(packed);
+
+		mimix_test_sample(&perf, &results[test_index]);
+		results[test_index].passed = zram_ok;
+		strncpy(results[test_index].test_name, "Zram_Store", 64);
+		printf("Test 15 - Compressed Page Store: %s\n",
+				results[test_index].passed ? "PASSED" : "FAILED");
+		test_index++;
+	}
+
+	/* Test 16: Kernel-state snapshot image */
+	mimix_perf_begin(&perf);
+	{
+		mimix_page_pool_t pool, restored;
+		mimix_pt_space_t spaces[2], back[2];
+		mimix_snap_writer_t *writer = (mimix_snap_writer_t *)
+				malloc(sizeof(mimix_snap_writer_t));
+		mimix_snap_t snap;
+		unsigned long pte = 0, saved_pte = 0;
+		unsigned int shift = 0;
+		char dir[] = MIMIX_SNAP_TEST_DIR;
+		char path[sizeof(MIMIX_SNAP_TEST_DIR) + 8];
+		FILE *image;
+		/* Private directory: no collisions, no planted symlinks */
+		int snap_ok = (writer != NULL && mkdtemp(dir) != NULL
+				&& mimix_page_pool_init(&pool, MIMIX_PT_TEST_POOL) == 0);
+
+		if (snap_ok) {
+			sprintf(path, "%s/image", dir);
+			/* Cold init, then save */
+			snap_ok &= (mimix_pt_init(&spaces[0], &pool, 1) == 0
+					&& mimix_pt_init(&spaces[1], &pool, 2) == 0);
+			snap_ok &= (mimix_pt_map(&spaces[0], MIMIX_PT_TEST_SMALL_VA,
+					MIMIX_PT_TEST_SMALL_PA, 16 * MIMIX_PAGE_SIZE,
+					MIMIX_PTE_WRITE) == 0
+					&& mimix_pt_map(&spaces[1], MIMIX_PT_TEST_HUGE_VA,
+					MIMIX_PT_TEST_HUGE_PA, MIMIX_PT_TEST_HUGE_LEN,
+					MIMIX_PT_ALLOW_HUGE) == 0);
+			snap_ok &= (mimix_pt_walk(&spaces[0], MIMIX_PT_TEST_SMALL_VA
+					+ 3 * MIMIX_PAGE_SIZE, &saved_pte, &shift) == 0);
+			snap_ok &= (mimix_snap_create(writer, path,
+					MIMIX_BUILD_ID) == 0
+					&& mimix_snap_save_paging(writer, &pool, spaces, 2) == 0
+					&& mimix_snap_commit(writer) == 0);
+
+			/* Restore: same translations, and the pool keeps allocating */
+			snap_ok &= (mimix_snap_open(&snap, path,
+					MIMIX_BUILD_ID) == 0);
+			if (snap_ok) {
+				snap_ok &= (mimix_snap_restore_paging(&snap, &restored, back,
+						2) == 0);
+				mimix_snap_close(&snap);
+			}
+			if (snap_ok) {
+				snap_ok &= (mimix_pt_walk(&back[0], MIMIX_PT_TEST_SMALL_VA
+						+ 3 * MIMIX_PAGE_SIZE, &pte, &shift) == 0
+						&& pte == saved_pte && shift == MIMIX_PAGE_SHIFT);
+				snap_ok &= (mimix_pt_walk(&back[1], MIMIX_PT_TEST_HUGE_VA,
+						&pte, &shift) == 0 && shift == 21);
+				snap_ok &= (restored.nfree == pool.nfree
+						&& back[1].tables == spaces[1].tables);
+				snap_ok &= (mimix_pt_map(&back[1], MIMIX_PT_TEST_SMALL_VA,
+						MIMIX_PT_TEST_SMALL_PA, MIMIX_PAGE_SIZE, 0) == 0
+						&& restored.nfree < pool.nfree);
+				mimix_pt_destroy(&back[0]);
+				mimix_pt_destroy(&back[1]);
+				snap_ok &= (restored.nfree == restored.npages);
+				mimix_page_pool_destroy(&restored);
+			}
+
+			/* Fallback cases: other build, missing file, damaged tables */
+			snap_ok &= (mimix_snap_open(&snap, path,
+					MIMIX_BUILD_ID + 1) != 0 && errno == ESTALE);
+			image = fopen(path, "r+b");
+			snap_ok &= (image != NULL);
+			if (image != NULL) {
+				fseek(image, (long) MIMIX_SNAP_ALIGN + 8, SEEK_SET);
+				fputc(0xFF, image);
+				fclose(image);
+			}
+			snap_ok &= (mimix_snap_open(&snap, path,
+					MIMIX_BUILD_ID) == 0);
+			if (snap_ok) {
+				snap_ok &= (mimix_snap_restore_paging(&snap, &restored, back,
+						2) != 0 && errno == EBADMSG);
+				mimix_snap_close(&snap);
+			}
+			remove(path);
+			snap_ok &= (mimix_snap_open(&snap, path,
+					MIMIX_BUILD_ID) != 0 && errno == ENOENT);
+
+			mimix_pt_destroy(&spaces[0]);
+			mimix_pt_destroy(&spaces[1]);
+			mimix_page_pool_destroy(&pool);
+		}
+		rmdir(dir);
+		free(writer);
+
+		mimix_test_sample(&perf, &results[test_index]);
+		results[test_index].passed = snap_ok;
+		strncpy(results[test_index].test_name, "Snapshot_Restore", 64);
+		printf("Test 16 - Kernel-State Snapshot: %s\n",
+				results[test_index].passed ? "PASSED" : "FAILED");
+		test_index++;
+	}
+
 	/* Summary Report */
 	printf("\nTest Summary:\n");
 	printf("============\n");
@@ -346,6 +1149,15 @@ int __attribute__((warn_unused_result)) main(void) {
 
 	printf("\nTotal: %d/%d tests passed\n", total_passed, test_index);
 
+	/* Per-case counters: IPC and misses per kilo-instruction */
+	printf("\nPerformance Counters:\n");
+	mimix_perf_print_header(stdout);
+	for (i = 0; i < test_index; i++) {
+		mimix_perf_print_row(stdout, results[i].test_name,
+				&results[i].counters);
+	}
+	mimix_perf_close(&perf);
+
 	/* Print key limits for verification */
 	printf("\nKey System Limits:\n");
 	printf("  CHAR_BIT: %d\n", MIMIX_CHAR_BIT);
@@ -0,0 +1,663 @@
+/* Performance Regression Suite for MIMIX 3.1.2
+ *
+ * Functional Testing: Repeated runs compared against a stored baseline
+ * Big O Analysis: O(n log n) per metric for the rank test
+ * Memory Testing: Fixed-size series, no allocation while recording
+ *
+ * Baselines are JSON documents written by bench_suite_save:
+ *
+ *     { "host": "...", "quick": 1, "metrics": [
+ *         { "name": "zram.store", "unit": "GB/s", "higher_is_better": 1,
+ *           "samples": [ 0.437, 0.441, ... ] }, ... ] }
+ *
+ * The loader reads that shape and skips keys it does not know. The
+ * Mann-Whitney U test is exact when no samples tie, which is the usual
+ * case for timings; ties fall back to the normal approximation with tie
+ * and continuity corrections. The approximation understates how extreme
+ * a clean separation is at ten runs a side, which after the correction
+ * below hid real regressions. p-values are adjusted with
+ * Benjamini-Hochberg across all compared metrics, so alpha bounds the
+ * expected share of false alarms, not the rate per metric.
+ */
+
+#include <headers/perf.h>
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "bench.h"
+
+#define BENCH_JSON_MAX      (4UL * 1024 * 1024)
+
+/* Self-check: a suite-sized set of metrics, one of them doctored */
+#define BENCH_CHECK_METRICS 85
+#define BENCH_CHECK_NOISE   0.02     /* Relative spread of every sample */
+#define BENCH_CHECK_SLOWER  1.30     /* Doctored metric: 30% slower */
+
+/* One value to order: a pooled sample or a metric's p-value */
+typedef struct bench_rank {
+	double value;
+	int tag;                          /* 1 for current samples, or an index */
+} bench_rank_t;
+
+/* JSON cursor */
+typedef struct bench_json {
+	const char *p;
+	const char *end;
+} bench_json_t;
+
+/* Neither infinity nor NaN: JSON has no spelling for them
+ * Complexity: O(1)
+ */
+static int bench_finite(double x) {
+	return x - x == 0.0;
+}
+
+void bench_suite_init(bench_suite_t *suite, int quick) {
+	memset(suite, 0, sizeof(*suite));
+	suite->quick = quick;
+	if (gethostname(suite->host, sizeof(suite->host) - 1) != 0) {
+		strcpy(suite->host, "unknown");
+	}
+}
+
+static bench_series_t *bench_suite_find(const bench_suite_t *suite,
+		const char *name) {
+	int i;
+
+	for (i = 0; i < suite->nseries; i++) {
+		if (strcmp(suite->series[i].name, name) == 0) {
+			return (bench_series_t *) &suite->series[i];
+		}
+	}
+	return NULL;
+}
+
+void bench_suite_record(bench_suite_t *suite, const bench_ctx_t *ctx) {
+	int i;
+
+	for (i = 0; i < ctx->nmetrics; i++) {
+		const bench_metric_t *m = &ctx->metrics[i];
+		bench_series_t *s = bench_suite_find(suite, m->name);
+
+		/* e.g. a ratio over a phase too fast for the clock */
+		if (!bench_finite(m->value)) {
+			fprintf(stderr, "%s: non-finite sample dropped\n", m->name);
+			continue;
+		}
+		if (s == NULL) {
+			if (suite->nseries == BENCH_MAX_SERIES) {
+				continue;
+			}
+			s = &suite->series[suite->nseries++];
+			strcpy(s->name, m->name);
+			sprintf(s->unit, "%.*s", BENCH_UNIT_MAX - 1, m->unit);
+			s->higher_is_better = m->higher_is_better;
+		}
+		if (s->nsamples < BENCH_MAX_RUNS) {
+			s->samples[s->nsamples++] = m->value;
+		}
+	}
+}
+
+/* Names and units are plain ASCII, so only quotes and backslashes escape */
+static void bench_json_put_string(FILE *f, const char *s) {
+	fputc('"', f);
+	for (; *s != '\0'; s++) {
+		if (*s == '"' || *s == '\\') {
+			fputc('\\', f);
+		}
+		fputc(*s, f);
+	}
+	fputc('"', f);
+}
+
+int bench_suite_save(const bench_suite_t *suite, const char *path) {
+	FILE *f = fopen(path, "w");
+	int i, k;
+
+	if (f == NULL) {
+		return -1;
+	}
+	fprintf(f, "{\n  \"host\": ");
+	bench_json_put_string(f, suite->host);
+	fprintf(f, ",\n  \"quick\": %d,\n  \"metrics\": [", suite->quick);
+	for (i = 0; i < suite->nseries; i++) {
+		const bench_series_t *s = &suite->series[i];
+
+		fprintf(f, "%s\n    { \"name\": ", i ? "," : "");
+		bench_json_put_string(f, s->name);
+		fprintf(f, ", \"unit\": ");
+		bench_json_put_string(f, s->unit);
+		fprintf(f, ", \"higher_is_better\": %d,\n      \"samples\": [",
+				s->higher_is_better);
+		for (k = 0; k < s->nsamples; k++) {
+			fprintf(f, "%s%.17g", k ? ", " : " ", s->samples[k]);
+		}
+		fprintf(f, " ] }");
+	}
+	fprintf(f, "\n  ]\n}\n");
+	if (fclose(f) != 0) {
+		return -1;
+	}
+	return 0;
+}
+
+static void bench_json_ws(bench_json_t *j) {
+	while (j->p < j->end && (*j->p == ' ' || *j->p == '\n' || *j->p == '\t'
+			|| *j->p == '\r')) {
+		j->p++;
+	}
+}
+
+/* Consume c after optional whitespace
+ * Complexity: O(1)
+ */
+static int bench_json_eat(bench_json_t *j, char c) {
+	bench_json_ws(j);
+	if (j->p < j->end && *j->p == c) {
+		j->p++;
+		return 1;
+	}
+	return 0;
+}
+
+static int bench_json_string(bench_json_t *j, char *out, size_t cap) {
+	size_t n = 0;
+
+	if (!bench_json_eat(j, '"')) {
+		return -1;
+	}
+	while (j->p < j->end && *j->p != '"') {
+		if (*j->p == '\\' && ++j->p == j->end) {
+			return -1;
+		}
+		if (out != NULL && n + 1 < cap) {
+			out[n++] = *j->p;
+		}
+		j->p++;
+	}
+	if (out != NULL && cap > 0) {
+		out[n] = '\0';
+	}
+	return bench_json_eat(j, '"') ? 0 : -1;
+}
+
+static int bench_json_number(bench_json_t *j, double *out) {
+	char buf[64];
+	char *end;
+	size_t n = 0;
+
+	bench_json_ws(j);
+	while (j->p + n < j->end && n + 1 < sizeof(buf)
+			&& strchr("+-0123456789.eE", j->p[n]) != NULL) {
+		buf[n] = j->p[n];
+		n++;
+	}
+	buf[n] = '\0';
+	*out = strtod(buf, &end);
+	if (n == 0 || *end != '\0' || !bench_finite(*out)) {
+		return -1;
+	}
+	j->p += n;
+	return 0;
+}
+
+/* Skip any value: the loader ignores keys it does not know
+ * Complexity: O(value length)
+ */
+static int bench_json_skip(bench_json_t *j) {
+	double number;
+
+	bench_json_ws(j);
+	if (j->p == j->end) {
+		return -1;
+	}
+	if (*j->p == '"') {
+		return bench_json_string(j, NULL, 0);
+	}
+	if (*j->p == '[' || *j->p == '{') {
+		char close = (*j->p == '[') ? ']' : '}';
+
+		j->p++;
+		if (bench_json_eat(j, close)) {
+			return 0;
+		}
+		do {
+			if (close == '}' && (bench_json_string(j, NULL, 0) != 0
+					|| !bench_json_eat(j, ':'))) {
+				return -1;
+			}
+			if (bench_json_skip(j) != 0) {
+				return -1;
+			}
+		} while (bench_json_eat(j, ','));
+		return bench_json_eat(j, close) ? 0 : -1;
+	}
+	if (strncmp(j->p, "true", 4) == 0 || strncmp(j->p, "null", 4) == 0) {
+		j->p += 4;
+		return 0;
+	}
+	if (strncmp(j->p, "false", 5) == 0) {
+		j->p += 5;
+		return 0;
+	}
+	return bench_json_number(j, &number);
+}
+
+static int bench_json_series(bench_json_t *j, bench_series_t *s) {
+	char key[32];
+	double number;
+
+	if (!bench_json_eat(j, '{')) {
+		return -1;
+	}
+	do {
+		if (bench_json_string(j, key, sizeof(key)) != 0
+				|| !bench_json_eat(j, ':')) {
+			return -1;
+		}
+		if (strcmp(key, "name") == 0) {
+			if (bench_json_string(j, s->name, sizeof(s->name)) != 0) {
+				return -1;
+			}
+		} else if (strcmp(key, "unit") == 0) {
+			if (bench_json_string(j, s->unit, sizeof(s->unit)) != 0) {
+				return -1;
+			}
+		} else if (strcmp(key, "higher_is_better") == 0) {
+			if (bench_json_number(j, &number) != 0) {
+				return -1;
+			}
+			s->higher_is_better = (number != 0.0);
+		} else if (strcmp(key, "samples") == 0) {
+			if (!bench_json_eat(j, '[')) {
+				return -1;
+			}
+			if (!bench_json_eat(j, ']')) {
+				do {
+					if (bench_json_number(j, &number) != 0) {
+						return -1;
+					}
+					if (s->nsamples < BENCH_MAX_RUNS) {
+						s->samples[s->nsamples++] = number;
+					}
+				} while (bench_json_eat(j, ','));
+				if (!bench_json_eat(j, ']')) {
+					return -1;
+				}
+			}
+		} else if (bench_json_skip(j) != 0) {
+			return -1;
+		}
+	} while (bench_json_eat(j, ','));
+	return bench_json_eat(j, '}') ? 0 : -1;
+}
+
+static int bench_json_suite(bench_json_t *j, bench_suite_t *suite) {
+	char key[32];
+	double number;
+
+	if (!bench_json_eat(j, '{')) {
+		return -1;
+	}
+	do {
+		if (bench_json_string(j, key, sizeof(key)) != 0
+				|| !bench_json_eat(j, ':')) {
+			return -1;
+		}
+		if (strcmp(key, "host") == 0) {
+			if (bench_json_string(j, suite->host, sizeof(suite->host)) != 0) {
+				return -1;
+			}
+		} else if (strcmp(key, "quick") == 0) {
+			if (bench_json_number(j, &number) != 0) {
+				return -1;
+			}
+			suite->quick = (number != 0.0);
+		} else if (strcmp(key, "metrics") == 0) {
+			if (!bench_json_eat(j, '[')) {
+				return -1;
+			}
+			if (!bench_json_eat(j, ']')) {
+				do {
+					if (suite->nseries == BENCH_MAX_SERIES
+							|| bench_json_series(j,
+									&suite->series[suite->nseries++]) != 0) {
+						return -1;
+					}
+				} while (bench_json_eat(j, ','));
+				if (!bench_json_eat(j, ']')) {
+					return -1;
+				}
+			}
+		} else if (bench_json_skip(j) != 0) {
+			return -1;
+		}
+	} while (bench_json_eat(j, ','));
+	return bench_json_eat(j, '}') ? 0 : -1;
+}
+
+int bench_suite_load(bench_suite_t *suite, const char *path) {
+	FILE *f = fopen(path, "r");
+	bench_json_t j;
+	char *text;
+	size_t len;
+	int status;
+
+	memset(suite, 0, sizeof(*suite));
+	if (f == NULL) {
+		return -1;
+	}
+	text = (char *) malloc(BENCH_JSON_MAX);
+	if (text == NULL) {
+		fclose(f);
+		errno = ENOMEM;
+		return -1;
+	}
+	len = fread(text, 1, BENCH_JSON_MAX, f);
+	fclose(f);
+	j.p = text;
+	j.end = text + len;
+	status = (len < BENCH_JSON_MAX) ? bench_json_suite(&j, suite) : -1;
+	free(text);
+	if (status != 0) {
+		errno = EINVAL;
+		return -1;
+	}
+	return 0;
+}
+
+static int bench_rank_cmp(const void *a, const void *b) {
+	double x = ((const bench_rank_t *) a)->value;
+	double y = ((const bench_rank_t *) b)->value;
+
+	return (x < y) ? -1 : (x > y);
+}
+
+static int bench_double_cmp(const void *a, const void *b) {
+	double x = *(const double *) a;
+	double y = *(const double *) b;
+
+	return (x < y) ? -1 : (x > y);
+}
+
+/* Exact P(U >= u) without ties: the null counts of U are the
+ * coefficients of the Gaussian binomial [n1 + n2, n1], built one factor
+ * at a time. Every partial product is again a polynomial of degree at
+ * most n1 * n2, so truncating there loses nothing.
+ * Complexity: O(n1 * n2 * n2)
+ */
+static double bench_mann_whitney_exact(int n1, int n2, double u) {
+	double counts[BENCH_MAX_RUNS * BENCH_MAX_RUNS + 1];
+	double tail = 0.0, total = 0.0;
+	int max = n1 * n2;
+	int i, v;
+
+	memset(counts, 0, (size_t) (max + 1) * sizeof(double));
+	counts[0] = 1.0;
+	for (i = 1; i <= n2; i++) {
+		for (v = max; v >= n1 + i; v--) {
+			counts[v] -= counts[v - n1 - i];   /* times (1 - q^(n1 + i)) */
+		}
+		for (v = i; v <= max; v++) {
+			counts[v] += counts[v - i];        /* over (1 - q^i) */
+		}
+	}
+	for (v = 0; v <= max; v++) {
+		total += counts[v];
+		if (v >= u) {
+			tail += counts[v];
+		}
+	}
+	return tail / total;
+}
+
+/* One-sided p-value that cur tends to exceed base
+ * Complexity: O(n log n) with ties, O(nbase * ncur^2) without
+ */
+double bench_mann_whitney(const double *base, int nbase, const double *cur,
+		int ncur) {
+	bench_rank_t pooled[2 * BENCH_MAX_RUNS];
+	double rank_sum = 0.0, ties = 0.0;
+	double n1 = nbase, n2 = ncur, n = nbase + ncur;
+	double u, mean, sigma;
+	int i, k, m, t;
+
+	if (nbase < 1 || ncur < 1 || nbase > BENCH_MAX_RUNS
+			|| ncur > BENCH_MAX_RUNS) {
+		return 1.0;
+	}
+	for (i = 0; i < nbase; i++) {
+		pooled[i].value = base[i];
+		pooled[i].tag = 0;
+	}
+	for (i = 0; i < ncur; i++) {
+		pooled[nbase + i].value = cur[i];
+		pooled[nbase + i].tag = 1;
+	}
+	qsort(pooled, (size_t) (nbase + ncur), sizeof(pooled[0]), bench_rank_cmp);
+
+	/* Tied runs share the average of ranks i + 1 .. k */
+	for (i = 0; i < nbase + ncur; i = k) {
+		k = i + 1;
+		while (k < nbase + ncur && pooled[k].value == pooled[i].value) {
+			k++;
+		}
+		t = k - i;
+		ties += (double) t * t * t - t;
+		for (m = i; m < k; m++) {
+			if (pooled[m].tag) {
+				rank_sum += (double) (i + 1 + k) / 2.0;
+			}
+		}
+	}
+
+	u = rank_sum - n2 * (n2 + 1.0) / 2.0;
+	if (ties == 0.0) {
+		return bench_mann_whitney_exact(nbase, ncur, u);
+	}
+	mean = n1 * n2 / 2.0;
+	sigma = sqrt(n1 * n2 / 12.0 * ((n + 1.0) - ties / (n * (n - 1.0))));
+	if (sigma == 0.0) {
+		return 1.0;
+	}
+	return 0.5 * erfc((u - mean - 0.5) / sigma / sqrt(2.0));
+}
+
+static double bench_median(const bench_series_t *s) {
+	double sorted[BENCH_MAX_RUNS];
+	int n = s->nsamples;
+
+	memcpy(sorted, s->samples, (size_t) n * sizeof(double));
+	qsort(sorted, (size_t) n, sizeof(double), bench_double_cmp);
+	return (n % 2) ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2.0;
+}
+
+/* Flip lower-is-better metrics so "larger" always means "worse"
+ * Complexity: O(n)
+ */
+static void bench_badness(const bench_series_t *s, double *out) {
+	int i;
+
+	for (i = 0; i < s->nsamples; i++) {
+		out[i] = s->higher_is_better ? -s->samples[i] : s->samples[i];
+	}
+}
+
+/* Benjamini-Hochberg: turn p-values into q-values across n metrics
+ * Complexity: O(n log n)
+ */
+static void bench_fdr_adjust(const double *p, double *q, int n) {
+	bench_rank_t *order;
+	double running = 1.0;
+	int i;
+
+	order = (bench_rank_t *) malloc((size_t) (n + 1) * sizeof(bench_rank_t));
+	if (order == NULL) {
+		/* Bonferroni needs no ordering and is never less strict */
+		for (i = 0; i < n; i++) {
+			q[i] = (p[i] * n < 1.0) ? p[i] * n : 1.0;
+		}
+		return;
+	}
+	for (i = 0; i < n; i++) {
+		order[i].value = p[i];
+		order[i].tag = i;
+	}
+	qsort(order, (size_t) n, sizeof(order[0]), bench_rank_cmp);
+	for (i = n - 1; i >= 0; i--) {
+		double scaled = order[i].value * n / (i + 1);
+
+		running = (scaled < running) ? scaled : running;
+		q[order[i].tag] = running;
+	}
+	free(order);
+}
+
+int bench_suite_compare(const bench_suite_t *base, const bench_suite_t *cur,
+		double alpha, double min_effect) {
+	double *stats = (double *) malloc(6 * BENCH_MAX_SERIES * sizeof(double));
+	double *p_worse = stats, *p_better = stats + BENCH_MAX_SERIES;
+	double *q_worse = stats + 2 * BENCH_MAX_SERIES;
+	double *q_better = stats + 3 * BENCH_MAX_SERIES;
+	double *medians = stats + 4 * BENCH_MAX_SERIES;  /* base, cur pairs */
+	const bench_series_t *matched[BENCH_MAX_SERIES];
+	int regressions = 0;
+	int i, n = 0;
+
+	if (stats == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+
+	/* First pass: test every metric present in both runs */
+	for (i = 0; i < cur->nseries; i++) {
+		const bench_series_t *c = &cur->series[i];
+		const bench_series_t *b = bench_suite_find(base, c->name);
+		double bad_base[BENCH_MAX_RUNS], bad_cur[BENCH_MAX_RUNS];
+
+		matched[i] = b;
+		if (b == NULL || b->nsamples < 2 || c->nsamples < 2) {
+			matched[i] = NULL;
+			continue;
+		}
+		bench_badness(b, bad_base);
+		bench_badness(c, bad_cur);
+		p_worse[n] = bench_mann_whitney(bad_base, b->nsamples, bad_cur,
+				c->nsamples);
+		p_better[n] = bench_mann_whitney(bad_cur, c->nsamples, bad_base,
+				b->nsamples);
+		medians[2 * n] = bench_median(b);
+		medians[2 * n + 1] = bench_median(c);
+		n++;
+	}
+
+	/* Many metrics at one alpha would flag noise; bound the false share */
+	bench_fdr_adjust(p_worse, q_worse, n);
+	bench_fdr_adjust(p_better, q_better, n);
+
+	printf("\nRegression check against %s (FDR %.3g, min effect %.1f%%)\n",
+			base->host, alpha, 100.0 * min_effect);
+	printf("  %-40s %12s %12s %8s %8s  %s\n", "metric", "baseline", "current",
+			"change", "q", "verdict");
+	for (i = 0, n = 0; i < cur->nseries; i++) {
+		const bench_series_t *c = &cur->series[i];
+		double mb, mc, change, worse;
+		const char *verdict = "ok";
+
+		if (matched[i] == NULL) {
+			printf("  %-40s %12s %12s %8s %8s  %s\n", c->name, "-", "-", "-",
+					"-", "no baseline");
+			continue;
+		}
+		mb = medians[2 * n];
+		mc = medians[2 * n + 1];
+		change = (mb != 0.0) ? (mc - mb) / fabs(mb) : 0.0;
+		worse = c->higher_is_better ? -change : change;
+
+		/* Significance alone flags sub-percent drift on quiet metrics */
+		if (q_worse[n] < alpha && worse >= min_effect) {
+			verdict = "REGRESSED";
+			regressions++;
+		} else if (q_better[n] < alpha && -worse >= min_effect) {
+			verdict = "improved";
+		}
+		printf("  %-40s %12.4g %12.4g %+7.1f%% %8.4f  %s\n", c->name, mb, mc,
+				100.0 * change, (q_worse[n] < q_better[n]) ? q_worse[n]
+				: q_better[n], verdict);
+		n++;
+	}
+	printf("\n  %d regression%s\n", regressions, (regressions == 1) ? "" : "s");
+	free(stats);
+	return regressions;
+}
+
+/* Generator for the self-check: xorshift64 mapped to [-1, 1)
+ * Complexity: O(1)
+ */
+static double bench_check_noise(unsigned long *state) {
+	unsigned long x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	*state = x;
+	return (double) (x >> 11) / (double) (1UL << 52) - 1.0;
+}
+
+int bench_suite_selftest(int runs, double alpha, double min_effect) {
+	bench_suite_t *suite = (bench_suite_t *) malloc(2 * sizeof(bench_suite_t));
+	bench_suite_t *base = suite, *cur = suite + 1;
+	unsigned long state = 0x9E3779B97F4A7C15UL;
+	int regressions;
+	int i, k;
+
+	if (suite == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	bench_suite_init(base, 1);
+	bench_suite_init(cur, 1);
+	for (i = 0; i < BENCH_CHECK_METRICS; i++) {
+		bench_series_t *b = &base->series[i];
+		bench_series_t *c = &cur->series[i];
+
+		sprintf(b->name, "selftest.metric_%02d", i);
+		strcpy(b->unit, "ms");
+		b->higher_is_better = BENCH_LOWER_BETTER;
+		b->nsamples = runs;
+		*c = *b;
+		for (k = 0; k < runs; k++) {
+			b->samples[k] = 100.0 * (1.0 + BENCH_CHECK_NOISE
+					* bench_check_noise(&state));
+			c->samples[k] = 100.0 * (1.0 + BENCH_CHECK_NOISE
+					* bench_check_noise(&state));
+		}
+	}
+	base->nseries = cur->nseries = BENCH_CHECK_METRICS;
+
+	/* Metric 0 regressed, but one run landed amid the baseline anyway */
+	for (k = 0; k < runs; k++) {
+		cur->series[0].samples[k] *= BENCH_CHECK_SLOWER;
+	}
+	cur->series[0].samples[runs / 2] = bench_median(&base->series[0])
+			* (1.0 + BENCH_CHECK_NOISE / 10.0);
+
+	printf("\nSelf-check: %d metrics x %d runs, metric_00 %.0f%% slower with "
+			"one outlier\n", BENCH_CHECK_METRICS, runs,
+			100.0 * (BENCH_CHECK_SLOWER - 1.0));
+	regressions = bench_suite_compare(base, cur, alpha, min_effect);
+	free(suite);
+
+	/* Others stay within the noise, far below min_effect */
+	if (regressions != 1) {
+		printf("Self-check FAILED: the doctored metric was %s\n",
+				(regressions == 0) ? "missed" : "not the only one flagged");
+		return -1;
+	}
+	printf("Self-check PASSED\n");
+	return 0;
+}